@@ -0,0 +1,317 @@
+// Micro-benchmarks of the hot paths of kck and cbx.
+//
+// bench_combox [--from=5] [--to=9] [--warmup=2] [--reps=10] [--out=path]
+//
+// Every benchmark runs warmup unmeasured and reps measured repetitions.
+// A repetition repeats the operation until it took at least 20 ms, the
+// reported times are per operation. The inputs are generated from a fixed
+// seed, so runs of different builds see the same graphs.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "finder.hpp"
+#include "kck_utils.hpp"
+
+using namespace kck;
+
+//// Harness //////////////////////////////////////////////////////////////////
+
+struct bench_result_t
+{
+    std::string name;
+    int n;
+    long iterations;
+    std::vector< double > samples;  // ns per operation
+};
+
+struct bench_t
+{
+    int warmup = 2;
+    int reps = 10;
+    std::vector< bench_result_t > results;
+
+    // Times op(), which returns the number of operations it performed.
+    template < typename op_t >
+    void run( const std::string &name, int n, op_t op )
+    {
+        using clock = std::chrono::steady_clock;
+        const double min_rep = 0.02;
+
+        auto measure = [ & ]( long iterations, long &ops )
+        {
+            ops = 0;
+            auto start = clock::now();
+            for ( long i = 0; i < iterations; i++ )
+                ops += op();
+            return std::chrono::duration< double >( clock::now() - start ).count();
+        };
+
+        // Calibrate the iterations of one repetition, which doubles as the
+        // first warm-up round.
+        long iterations = 1, ops;
+        double seconds;
+        while ( ( seconds = measure( iterations, ops ) ) < min_rep && iterations < ( 1 << 24 ) )
+            iterations *= 2;
+
+        for ( int i = 1; i < warmup; i++ )
+            measure( iterations, ops );
+
+        bench_result_t res{ name, n, iterations, {} };
+        for ( int i = 0; i < reps; i++ )
+        {
+            seconds = measure( iterations, ops );
+            res.samples.push_back( seconds * 1e9 / std::max( ops, 1L ) );
+        }
+
+        std::cerr << name << " n=" << n << " " << res.samples[ 0 ] << " ns\n";
+        results.push_back( std::move( res ) );
+    }
+
+    void write( std::ostream &os ) const
+    {
+        os << "{\n  \"warmup\": " << warmup << ",\n  \"reps\": " << reps
+           << ",\n  \"unit\": \"ns/op\",\n  \"benchmarks\": [";
+        for ( std::size_t i = 0; i < results.size(); i++ )
+        {
+            auto &r = results[ i ];
+            auto s = r.samples;
+            std::sort( s.begin(), s.end() );
+            double mean = std::accumulate( s.begin(), s.end(), 0.0 ) / s.size();
+            double variance = 0;
+            for ( double x : s )
+                variance += ( x - mean ) * ( x - mean );
+            variance /= std::max< std::size_t >( s.size() - 1, 1 );
+
+            os << ( i ? ",\n" : "\n" )
+               << "    { \"name\": \"" << r.name << "\", \"n\": " << r.n
+               << ", \"iterations\": " << r.iterations
+               << ", \"mean\": " << mean
+               << ", \"median\": " << s[ s.size() / 2 ]
+               << ", \"min\": " << s.front()
+               << ", \"max\": " << s.back()
+               << ", \"variance\": " << variance
+               << ", \"stddev\": " << std::sqrt( variance ) << " }";
+        }
+        os << "\n  ]\n}\n";
+    }
+};
+
+//// Inputs ///////////////////////////////////////////////////////////////////
+
+std::vector< cbx::hypergraph_t > random_graphs( int n, int count, std::mt19937_64 &rng )
+{
+    std::vector< cbx::hypergraph_t > graphs;
+    std::bernoulli_distribution coin( 0.5 );
+    for ( int c = 0; c < count; c++ )
+    {
+        cbx::hypergraph_t g( n );
+        for ( int e = 0; e < g.slots(); e++ )
+            if ( coin( rng ) )
+                g.add_edge( e );
+        graphs.push_back( g );
+    }
+    return graphs;
+}
+
+//// Benchmarks ///////////////////////////////////////////////////////////////
+
+void bench_encoding( bench_t &b, int n )
+{
+    b.run( "to_cnf", n, [ & ]()
+    {
+        auto cnf = build_coloring_cnf( n, 7, blue_palette );
+        return 1;
+    } );
+
+    auto blue = build_coloring_cnf( n, 7, blue_palette );
+
+    b.run( "to_int_cnf", n, [ & ]()
+    {
+        auto translated = to_int_cnf( blue );
+        return 1;
+    } );
+
+    auto [ translated, translation ] = to_int_cnf( blue );
+
+    b.run( "add_cnf", n, [ & ]()
+    {
+        sat_solver_t solver;
+        add_cnf( solver, translated );
+        return 1;
+    } );
+
+    b.run( "cnf_get_stats", n, [ & ]()
+    {
+        volatile int clauses = cnf_get_stats( blue ).clauses;
+        ( void ) clauses;
+        return 1;
+    } );
+}
+
+// The red formula has n! * C(n,3) role constraints, so it is only built for
+// small n.
+void bench_red_encoding( bench_t &b, int n )
+{
+    b.run( "red_to_cnf", n, [ & ]()
+    {
+        cnf_builder< lit_t > builder( labeler );
+        auto cnf = red_uncolor_formula( n )->to_cnf( builder );
+        return 1;
+    } );
+}
+
+void bench_coloring( bench_t &b, int n, std::mt19937_64 &rng )
+{
+    lat_hypergraph_t h( n );
+    auto graphs = random_graphs( n, 64, rng );
+
+    std::vector< std::vector< int > > perms;
+    std::vector< int > perm( n );
+    std::iota( perm.begin(), perm.end(), 0 );
+    for ( int i = 0; i < 64; i++ )
+    {
+        std::shuffle( perm.begin(), perm.end(), rng );
+        perms.push_back( perm );
+    }
+
+    std::size_t next = 0;
+    b.run( "is_perm_colorable", n, [ & ]()
+    {
+        h.graph = graphs[ next % graphs.size() ];
+        volatile bool c = is_perm_colorable( h, perms[ next % perms.size() ] );
+        ( void ) c;
+        next++;
+        return 1;
+    } );
+
+    next = 0;
+    b.run( "is_r_uncolorable", n, [ & ]()
+    {
+        h.graph = graphs[ next++ % graphs.size() ];
+        volatile bool c = is_r_uncolorable( h );
+        ( void ) c;
+        return 1;
+    } );
+
+    next = 0;
+    b.run( "solve_blue", n, [ & ]()
+    {
+        h.graph = graphs[ next++ % graphs.size() ];
+        volatile int res = h.solve_blue();
+        ( void ) res;
+        return 1;
+    } );
+}
+
+// Time per tested lattice node, with the real predicates, for a branching
+// order. The traversal is cut off after a fixed number of nodes
+// and leaves h empty again.
+void bench_traversal( bench_t &b, int n, const std::string &order )
+{
+    const long budget = 2000;
+    lat_hypergraph_t h( n );
+    h.set_order( make_lat_order( order, h ) );
+
+    std::string name = "trav_3hg_lat_node";
+    if ( order != "index" )
+        name += "_" + order;
+
+    b.run( name, n, [ & ]()
+    {
+        long nodes = 0;
+        auto stop = [ & ]( lat_hypergraph_t &g )
+        {
+            return ++nodes > budget || is_b_uncolorable( g );
+        };
+        // Solutions are dropped, keeping them would grow h over the
+        // iterations.
+        auto collect = []( lat_hypergraph_t& ) {};
+        cbx::trav_3hg_lat_go( h, 0, true, stop, is_r_uncolorable, collect );
+        return std::min( nodes, budget );
+    } );
+}
+
+// Whole sat mode with and without a DRAT proof written to a scratch file.
+void bench_proof( bench_t &b, int n )
+{
+    cnf_builder< lit_t > builder( labeler );
+    auto formula = build_coloring_cnf( n, 7, blue_palette, builder );
+    add_to( formula, red_uncolor_formula( n )->to_cnf( builder ) );
+    auto [ translated, translation ] = to_int_cnf( formula );
+
+    for ( bool traced : { false, true } )
+        b.run( traced ? "solve_proof_on" : "solve_proof_off", n, [ & ]()
+        {
+            sat_solver_t solver;
+            std::unique_ptr< proof_sink > proof;
+            if ( traced )
+                proof = std::make_unique< proof_sink >( solver, "bench_combox.drat", false );
+            add_cnf( solver, translated );
+            volatile int res = solver.solve();
+            ( void ) res;
+            if ( proof )
+                proof->close();
+            return 1;
+        } );
+    std::remove( "bench_combox.drat" );
+}
+
+//// Main /////////////////////////////////////////////////////////////////////
+
+int main( int arc, char** argv )
+{
+    bench_t b;
+    int from = 5, to = 9;
+    std::string out_path;
+
+    for ( int i = 1; i < arc; i++ )
+    {
+        std::string arg = argv[ i ];
+        auto value = [ & ]() { return arg.substr( arg.find( '=' ) + 1 ); };
+        if ( arg.rfind( "--from=", 0 ) == 0 ) from = std::stoi( value() );
+        else if ( arg.rfind( "--to=", 0 ) == 0 ) to = std::stoi( value() );
+        else if ( arg.rfind( "--warmup=", 0 ) == 0 ) b.warmup = std::stoi( value() );
+        else if ( arg.rfind( "--reps=", 0 ) == 0 ) b.reps = std::stoi( value() );
+        else if ( arg.rfind( "--out=", 0 ) == 0 ) out_path = value();
+        else
+        {
+            std::cerr << "usage: bench_combox [--from=n] [--to=n] [--warmup=k] [--reps=k] [--out=path]\n";
+            return 1;
+        }
+    }
+    if ( b.reps < 1 )
+    {
+        std::cerr << "bench_combox: --reps has to be at least 1\n";
+        return 1;
+    }
+
+    std::mt19937_64 rng( 0x5eed );
+
+    for ( int n = from; n <= to; n++ )
+    {
+        bench_encoding( b, n );
+        if ( n <= 7 )
+            bench_red_encoding( b, n );
+        bench_coloring( b, n, rng );
+        for ( auto order : { "index", "degree", "palette" } )
+            bench_traversal( b, n, order );
+        if ( n <= 6 )
+            bench_proof( b, n );
+    }
+
+    if ( out_path.empty() )
+        b.write( std::cout );
+    else
+    {
+        std::ofstream out( out_path );
+        b.write( out );
+    }
+}
@@ -17,10 +17,38 @@ std::ostream& operator<<( std::ostream& os, const std::set< int > &e )
 std::ostream& operator<<( std::ostream& os, const cbx::hypergraph_t& h )
 {
     os << "Hypergraph[" << h.n << "]\n{\n";
-    for ( auto &e : h.edges )
-        kck::str_indent( os, 2 ) << e << std::endl;
+    for ( auto &t : h.edge_list() )
+        kck::str_indent( os, 2 ) << "{" << t[ 0 ] << ", " << t[ 1 ] << ", " << t[ 2 ] << "}"
+                                 << std::endl;
         
     return os << "}";
 }
 
+const edge_bits_t &vertex_mask( int v )
+{
+    static const auto masks = []()
+    {
+        std::vector< edge_bits_t > res( max_vertices );
+        for ( int e = 0; e < max_edges; e++ )
+            for ( int u : triple_of[ e ] )
+                res[ u ][ e ] = true;
+        return res;
+    }();
+    return masks[ v ];
+}
+
+const edge_bits_t &pair_mask( int u, int v )
+{
+    static const auto masks = []()
+    {
+        std::vector< edge_bits_t > res( max_vertices * max_vertices );
+        for ( int a = 0; a < max_vertices; a++ )
+            for ( int b = 0; b < max_vertices; b++ )
+                if ( a != b )
+                    res[ adj_i( max_vertices, a, b ) ] = vertex_mask( a ) & vertex_mask( b );
+        return res;
+    }();
+    return masks[ adj_i( max_vertices, u, v ) ];
+}
+
 }
@@ -1,28 +1,120 @@
 #pragma once
 
+#include <atomic>
+#include <bitset>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <set>
+#include <stdexcept>
+#include <string>
+#include <vector>
 
 #include "cbx_sim.hpp"
+#include "cbx_utils.hpp"
 #include "kck_log.hpp"
+#include "kck_pool.hpp"
+#include "kck_prof.hpp"
 #include "kck_str.hpp"
 
 namespace cbx {
 
-using hyperedge_t = std::tuple< int, int, int >;
+//// Hypergraph ///////////////////////////////////////////////////////////////
 
+// Hypergraphs have room for the edges on up to max_vertices vertices.
+constexpr int max_vertices = 16;
+constexpr int max_edges = choose( max_vertices, 3 );
+
+using edge_bits_t = std::bitset< max_edges >;
+
+// The triple of every rank below max_edges, so unranking is a lookup.
+struct triple_table_t
+{
+    triple_t triples[ max_edges ] = {};
+
+    constexpr triple_table_t()
+    {
+        for ( int e = 0; e < max_edges; e++ )
+            triples[ e ] = unrank_3( e );
+    }
+
+    constexpr const triple_t &operator[]( int e ) const { return triples[ e ]; }
+};
+
+inline constexpr triple_table_t triple_of{};
+
+// Edges containing v, and edges containing both u and v.
+const edge_bits_t &vertex_mask( int v );
+const edge_bits_t &pair_mask( int u, int v );
+
+// A 3-uniform hypergraph on the vertices 0, ..., n - 1. Bit e of edges is
+// the triple of rank e, which is the same for every n, so a hypergraph
+// on n vertices is also one on n + 1.
 struct hypergraph_t
 {
     int n;
-    std::set< std::set< int > > edges;
+    edge_bits_t edges;
+
+    hypergraph_t( int n ) : n( n )
+    {
+        if ( n < 0 || n > max_vertices )
+            throw std::invalid_argument( "hypergraph_t: " + std::to_string( n )
+                                       + " vertices do not fit" );
+    }
+
+    // The triples need not be sorted.
+    hypergraph_t( int n, std::initializer_list< triple_t > triples ) : hypergraph_t( n )
+    {
+        for ( auto &t : triples )
+            add_edge( t[ 0 ], t[ 1 ], t[ 2 ] );
+    }
+
+    // Number of possible edges, the ranks of the triples on n vertices.
+    int slots() const { return choose( n, 3 ); }
+
+    bool has_edge( int e ) const { return edges[ e ]; }
+    void add_edge( int e ) { edges[ e ] = true; }
+    void remove_edge( int e ) { edges[ e ] = false; }
+
+    bool has_edge( int i, int j, int k ) const { return edges[ rank_of( i, j, k ) ]; }
+    void add_edge( int i, int j, int k ) { edges[ rank_of( i, j, k ) ] = true; }
+    void remove_edge( int i, int j, int k ) { edges[ rank_of( i, j, k ) ] = false; }
+
+    int edge_count() const { return edges.count(); }
+
+    int degree( int v ) const { return ( edges & vertex_mask( v ) ).count(); }
 
-    hypergraph_t( int n ) : n( n ) {}
+    int codegree( int u, int v ) const { return ( edges & pair_mask( u, v ) ).count(); }
 
-    hypergraph_t( int n, std::set< std::set< int > > edges ) 
-        : n( n )
-        , edges( std::move( edges ) )
-    {}
+    // The edges in rank order.
+    std::vector< triple_t > edge_list() const
+    {
+        std::vector< triple_t > res;
+        for ( int e = 0; e < slots(); e++ )
+            if ( edges[ e ] )
+                res.push_back( triple_of[ e ] );
+        return res;
+    }
+
+    static int rank_of( int i, int j, int k )
+    {
+        sort_i( i, j, k );
+        return rank_3( i, j, k );
+    }
 };
 
+inline bool operator==( const hypergraph_t &a, const hypergraph_t &b )
+{
+    return a.n == b.n && a.edges == b.edges;
+}
+
+inline bool operator!=( const hypergraph_t &a, const hypergraph_t &b )
+{
+    return ! ( a == b );
+}
+
 std::ostream& operator<<( std::ostream& os, const std::set< int > &e );
 
 std::ostream& operator<<( std::ostream& os, const cbx::hypergraph_t& h );
@@ -33,14 +125,20 @@ using hg_pred = bool ( hg_t& );
 template < typename hg_t >
 using hg_coll = void ( hg_t& );
 
-template < typename hg_t >
+// The lattice traversals decide one edge per level, the one returned by
+// h.branch_edge( level ). It has to be an edge not decided on the levels
+// above, and for the parallel traversal the same one whenever the
+// traversal gets to the same node, since tasks are replayed through it.
+
+template < typename hg_t, typename break_t, typename yield_t, typename collect_t >
 void trav_3hg_lat_go( hg_t &h 
-                    , int edge_index
+                    , int level
                     , bool test
-                    , hg_pred< hg_t > break_fun
-                    , hg_pred< hg_t > yield_fun
-                    , hg_coll< hg_t > collect_fun )
+                    , break_t break_fun
+                    , yield_t yield_fun
+                    , collect_t collect_fun )
 {
+    KCK_PROF_SCOPE( "trav_3hg_lat_go" );
 
     if ( test ) 
     {
@@ -53,25 +151,26 @@ void trav_3hg_lat_go( hg_t &h
         }
     }
 
-    if ( edge_index >= cbx::choose( h.n, 3 ) ) 
+    if ( level >= cbx::choose( h.n, 3 ) ) 
         return;
 
-    h.remove_edge( edge_index );
-    trav_3hg_lat_go< hg_t >( h
-                           , edge_index + 1
-                           , false
-                           , break_fun
-                           , yield_fun
-                           , collect_fun );
-
-    h.add_edge( edge_index );
-    trav_3hg_lat_go< hg_t >( h
-                           , edge_index + 1
-                           , true
-                           , break_fun
-                           , yield_fun
-                           , collect_fun );
-    h.remove_edge( edge_index );
+    int edge = h.branch_edge( level );
+    h.remove_edge( edge );
+    trav_3hg_lat_go( h
+                   , level + 1
+                   , false
+                   , break_fun
+                   , yield_fun
+                   , collect_fun );
+
+    h.add_edge( edge );
+    trav_3hg_lat_go( h
+                   , level + 1
+                   , true
+                   , break_fun
+                   , yield_fun
+                   , collect_fun );
+    h.remove_edge( edge );
 }
 
 template < typename hg_t >
@@ -80,7 +179,176 @@ void trav_3hg_lat( hg_t &h
                  , hg_pred< hg_t > yield_fun
                  , hg_coll< hg_t > collect_fun )
 {
-    trav_3hg_lat_go< hg_t >( h, 0, true, break_fun, yield_fun, collect_fun );
+    trav_3hg_lat_go( h, 0, true, break_fun, yield_fun, collect_fun );
+}
+
+//// Parallel traversal ///////////////////////////////////////////////////////
+
+// A subtree of the lattice: the edges of the levels below level are fixed by
+// choices, the node itself has already been tested and the remaining edges
+// are absent.
+struct lat_task_t
+{
+    int level;
+    std::vector< bool > choices;
+};
+
+// Walks the top split_depth levels exactly like trav_3hg_lat_go and emits
+// the subtrees hanging below them as tasks.
+template < typename hg_t, typename break_t, typename yield_t, typename collect_t >
+void trav_3hg_lat_split( hg_t &h
+                       , int level
+                       , bool test
+                       , int split_depth
+                       , std::vector< bool > &choices
+                       , std::vector< lat_task_t > &tasks
+                       , break_t break_fun
+                       , yield_t yield_fun
+                       , collect_t collect_fun )
+{
+    if ( test )
+    {
+        if ( break_fun( h ) )
+            return;
+
+        if ( yield_fun( h ) ) {
+            collect_fun( h );
+            return;
+        }
+    }
+
+    if ( level >= cbx::choose( h.n, 3 ) )
+        return;
+
+    if ( level >= split_depth )
+    {
+        tasks.push_back( { level, choices } );
+        return;
+    }
+
+    int edge = h.branch_edge( level );
+    choices.push_back( false );
+    h.remove_edge( edge );
+    trav_3hg_lat_split( h, level + 1, false, split_depth, choices, tasks
+                      , break_fun, yield_fun, collect_fun );
+
+    choices.back() = true;
+    h.add_edge( edge );
+    trav_3hg_lat_split( h, level + 1, true, split_depth, choices, tasks
+                      , break_fun, yield_fun, collect_fun );
+    h.remove_edge( edge );
+    choices.pop_back();
+}
+
+// Controls a resumable parallel traversal.
+struct lat_control_t
+{
+    // Makes the workers abandon their subtrees, which then stay in the
+    // frontier. Lock-free, so it may be set from a signal handler.
+    std::atomic< bool > stop = false;
+
+    // Called with the frontier every interval and once more at the end.
+    // The frontier is empty iff the traversal is complete. No worker
+    // finishes a task while checkpoint runs.
+    std::function< void( const std::vector< lat_task_t >& ) > checkpoint;
+    std::chrono::milliseconds interval{ 0 };
+
+    // When set, the traversal continues from this frontier instead of
+    // starting at the bottom of the lattice.
+    std::optional< std::vector< lat_task_t > > resume;
+};
+
+// Parallel version of trav_3hg_lat. The lattice is cut at split_depth and
+// the subtrees are traversed by a work-stealing pool. hg_t has to provide a
+// copy constructor giving an independent worker and join( worker ), which
+// moves the counters and results of the worker into h; it is called after
+// every finished subtree, so h always describes exactly the subtrees which
+// left the frontier. retire( worker ) is called once per worker before it is
+// destroyed. collect_fun is serialised.
+template < typename hg_t >
+void trav_3hg_lat_par( hg_t &h
+                     , int threads
+                     , int split_depth
+                     , hg_pred< hg_t > break_fun
+                     , hg_pred< hg_t > yield_fun
+                     , hg_coll< hg_t > collect_fun
+                     , lat_control_t *control = nullptr )
+{
+    lat_control_t no_control;
+    if ( ! control )
+        control = &no_control;
+
+    std::vector< lat_task_t > tasks;
+    if ( control->resume )
+        tasks = *control->resume;
+    else
+    {
+        std::vector< bool > choices;
+        trav_3hg_lat_split( h, 0, true, split_depth, choices, tasks
+                          , break_fun, yield_fun, collect_fun );
+    }
+
+    kck::steal_pool< lat_task_t > pool( threads );
+    for ( auto &t : tasks )
+        pool.push( std::move( t ) );
+
+    std::vector< std::unique_ptr< hg_t > > workers;
+    for ( int w = 0; w < pool.size(); w++ )
+        workers.push_back( std::make_unique< hg_t >( h ) );
+
+    std::mutex collect_lock;
+    auto collect_sync = [ & ]( hg_t &w )
+    {
+        std::lock_guard< std::mutex > guard( collect_lock );
+        collect_fun( w );
+    };
+
+    auto break_or_stop = [ & ]( hg_t &w )
+    {
+        return control->stop || break_fun( w );
+    };
+
+    auto checkpoint = [ & ]()
+    {
+        if ( control->checkpoint )
+            pool.frontier( control->checkpoint );
+    };
+
+    if ( control->stop )
+        pool.halt();
+
+    pool.run( [ & ]( int w, lat_task_t &task )
+              {
+                  hg_t &wh = *workers[ w ];
+                  std::vector< int > fixed;
+                  for ( int i = 0; i < task.level; i++ )
+                  {
+                      fixed.push_back( wh.branch_edge( i ) );
+                      if ( task.choices[ i ] ) wh.add_edge( fixed.back() );
+                  }
+
+                  trav_3hg_lat_go( wh, task.level, false
+                                 , break_or_stop, yield_fun, collect_sync );
+
+                  for ( int e : fixed )
+                      wh.remove_edge( e );
+
+                  if ( control->stop )
+                      pool.halt();
+                  return ! control->stop;
+              }
+            , [ & ]( int w, lat_task_t& ) { h.join( *workers[ w ] ); }
+            , [ & ]()
+              {
+                  if ( control->stop )
+                      pool.halt();
+                  checkpoint();
+              }
+            , control->interval );
+
+    for ( auto &w : workers )
+        h.retire( *w );
+    checkpoint();
 }
 
 }
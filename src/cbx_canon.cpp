@@ -0,0 +1,357 @@
+#include "cbx_canon.hpp"
+
+#include <algorithm>
+#include <array>
+#include <numeric>
+#include <unordered_set>
+
+#include "cbx_sim.hpp"
+#include "cbx_utils.hpp"
+
+namespace cbx {
+
+namespace {
+
+struct partition_t
+{
+    // Vertices ordered by their cells.
+    std::vector< int > order;
+    // cell[ v ] is the position in order where the cell of v starts.
+    std::vector< int > cell;
+};
+
+struct canon_search
+{
+    int n;
+
+    // incident[ v ] holds the other two vertices of every edge containing v.
+    std::vector< std::vector< std::pair< int, int > > > incident;
+    std::vector< std::array< int, 3 > > edges;
+
+    std::vector< std::vector< int > > automorphisms;
+
+    bool have_leaf = false;
+    boost::dynamic_bitset<> first, best;
+    std::vector< int > first_lab, best_lab;
+    // The vertices individualised on the way to the first leaf.
+    std::vector< int > first_path;
+
+    canon_search( int n, const boost::dynamic_bitset<> &edge_set )
+        : n( n )
+        , incident( n )
+    {
+        for ( int k = 2; k < n; k++ )
+            for ( int j = 1; j < k; j++ )
+                for ( int i = 0; i < j; i++ )
+                {
+                    if ( ! edge_set[ rank_3( i, j, k ) ] )
+                        continue;
+                    edges.push_back( { i, j, k } );
+                    incident[ i ].push_back( { j, k } );
+                    incident[ j ].push_back( { i, k } );
+                    incident[ k ].push_back( { i, j } );
+                }
+    }
+
+    std::vector< int > signature( const partition_t &p, int v ) const
+    {
+        std::vector< int > sig;
+        sig.reserve( incident[ v ].size() );
+        for ( auto [ a, b ] : incident[ v ] )
+        {
+            int ca = p.cell[ a ], cb = p.cell[ b ];
+            if ( ca > cb ) std::swap( ca, cb );
+            sig.push_back( ca * n + cb );
+        }
+        std::sort( sig.begin(), sig.end() );
+        return sig;
+    }
+
+    // Splits cells by the multiset of cells the vertex co-occurs with in an
+    // edge until the partition is equitable in this sense. Cells keep their
+    // relative order and are split in signature order, so the result only
+    // depends on the isomorphism class of ( h, p ).
+    void refine( partition_t &p ) const
+    {
+        bool changed = true;
+        while ( changed )
+        {
+            changed = false;
+            int start = 0;
+            while ( start < n )
+            {
+                int end = start + 1;
+                while ( end < n && p.cell[ p.order[ end ] ] == start )
+                    end++;
+
+                if ( end - start > 1 )
+                {
+                    std::vector< std::pair< std::vector< int >, int > > sigs;
+                    for ( int i = start; i < end; i++ )
+                        sigs.push_back( { signature( p, p.order[ i ] )
+                                        , p.order[ i ] } );
+                    std::sort( sigs.begin(), sigs.end() );
+
+                    int cell_start = start;
+                    for ( int i = start; i < end; i++ )
+                    {
+                        auto &[ sig, v ] = sigs[ i - start ];
+                        if ( i > start && sig != sigs[ i - start - 1 ].first )
+                        {
+                            cell_start = i;
+                            changed = true;
+                        }
+                        p.order[ i ] = v;
+                        p.cell[ v ] = cell_start;
+                    }
+                }
+                start = end;
+            }
+        }
+    }
+
+    boost::dynamic_bitset<> relabel( const std::vector< int > &lab ) const
+    {
+        boost::dynamic_bitset<> res( choose( n, 3 ) );
+        for ( auto [ i, j, k ] : edges )
+        {
+            int a = lab[ i ], b = lab[ j ], c = lab[ k ];
+            sort_i( a, b, c );
+            res[ rank_3( a, b, c ) ] = true;
+        }
+        return res;
+    }
+
+    void record_automorphism( const std::vector< int > &lab
+                            , const std::vector< int > &ref_lab )
+    {
+        std::vector< int > ref_inv( n );
+        for ( int v = 0; v < n; v++ )
+            ref_inv[ ref_lab[ v ] ] = v;
+
+        std::vector< int > gamma( n );
+        bool identity = true;
+        for ( int v = 0; v < n; v++ )
+        {
+            gamma[ v ] = ref_inv[ lab[ v ] ];
+            identity &= gamma[ v ] == v;
+        }
+        if ( ! identity )
+            automorphisms.push_back( std::move( gamma ) );
+    }
+
+    void leaf( const partition_t &p, const std::vector< int > &path )
+    {
+        std::vector< int > lab( p.cell );
+        auto bits = relabel( lab );
+
+        if ( ! have_leaf )
+        {
+            have_leaf = true;
+            first = best = bits;
+            first_lab = best_lab = lab;
+            first_path = path;
+        }
+        else if ( bits == first )
+            record_automorphism( lab, first_lab );
+        else if ( bits == best )
+            record_automorphism( lab, best_lab );
+        else if ( best < bits )
+        {
+            best = std::move( bits );
+            best_lab = std::move( lab );
+        }
+    }
+
+    // Orbits of the group generated by the known automorphisms that fix
+    // every vertex on the current path.
+    std::vector< int > orbits( const std::vector< int > &path ) const
+    {
+        std::vector< int > parent( n );
+        std::iota( parent.begin(), parent.end(), 0 );
+        auto find = [&]( int v )
+        {
+            while ( parent[ v ] != v )
+                v = parent[ v ] = parent[ parent[ v ] ];
+            return v;
+        };
+
+        for ( auto &gamma : automorphisms )
+        {
+            bool fixes = std::all_of( path.begin(), path.end()
+                                    , [&]( int v ) { return gamma[ v ] == v; } );
+            if ( ! fixes ) continue;
+            for ( int v = 0; v < n; v++ )
+            {
+                int a = find( v ), b = find( gamma[ v ] );
+                if ( a != b ) parent[ std::max( a, b ) ] = std::min( a, b );
+            }
+        }
+
+        for ( int v = 0; v < n; v++ )
+            parent[ v ] = find( v );
+        return parent;
+    }
+
+    // |Aut( h )| by the orbit-stabiliser theorem along the first path: the
+    // automorphisms found below its i-th node fix the vertices above it and
+    // generate their stabiliser, so the order is the product of the orbit
+    // sizes of the individualised vertices.
+    std::uint64_t group_order() const
+    {
+        std::uint64_t order = 1;
+        std::vector< int > prefix;
+        for ( int v : first_path )
+        {
+            auto orbit = orbits( prefix );
+            order *= std::count( orbit.begin(), orbit.end(), orbit[ v ] );
+            prefix.push_back( v );
+        }
+        return order;
+    }
+
+    void search( partition_t p, std::vector< int > &path )
+    {
+        refine( p );
+
+        int start = 0;
+        while ( start < n )
+        {
+            int end = start + 1;
+            while ( end < n && p.cell[ p.order[ end ] ] == start )
+                end++;
+            if ( end - start > 1 )
+                break;
+            start = end;
+        }
+
+        if ( start >= n )
+            return leaf( p, path );
+
+        std::vector< int > target;
+        for ( int i = start; i < n && p.cell[ p.order[ i ] ] == start; i++ )
+            target.push_back( p.order[ i ] );
+
+        std::vector< int > explored;
+        for ( int v : target )
+        {
+            auto orbit = orbits( path );
+            bool seen = std::any_of( explored.begin(), explored.end()
+                                   , [&]( int u ) { return orbit[ u ] == orbit[ v ]; } );
+            if ( seen ) continue;
+            explored.push_back( v );
+
+            partition_t child = p;
+            auto pos = std::find( child.order.begin() + start
+                                , child.order.end(), v );
+            std::iter_swap( child.order.begin() + start, pos );
+            for ( std::size_t i = start + 1; i < start + target.size(); i++ )
+                child.cell[ child.order[ i ] ] = start + 1;
+            child.cell[ v ] = start;
+
+            path.push_back( v );
+            search( std::move( child ), path );
+            path.pop_back();
+        }
+    }
+};
+
+std::uint64_t splitmix64( std::uint64_t x )
+{
+    x += 0x9e3779b97f4a7c15ull;
+    x = ( x ^ ( x >> 30 ) ) * 0xbf58476d1ce4e5b9ull;
+    x = ( x ^ ( x >> 27 ) ) * 0x94d049bb133111ebull;
+    return x ^ ( x >> 31 );
+}
+
+std::uint64_t hash_bits( int n, const boost::dynamic_bitset<> &bits )
+{
+    std::vector< boost::dynamic_bitset<>::block_type > blocks;
+    boost::to_block_range( bits, std::back_inserter( blocks ) );
+
+    std::uint64_t h = splitmix64( n );
+    for ( auto b : blocks )
+        h = splitmix64( h ^ b );
+    return h;
+}
+
+}
+
+bool operator==( const canon_t &a, const canon_t &b )
+{
+    return a.n == b.n && a.hash == b.hash && a.edges == b.edges;
+}
+
+bool operator!=( const canon_t &a, const canon_t &b )
+{
+    return ! ( a == b );
+}
+
+boost::dynamic_bitset<> edge_bitset( const hypergraph_t &h )
+{
+    boost::dynamic_bitset<> res( h.slots() );
+    for ( int e = 0; e < h.slots(); e++ )
+        res[ e ] = h.has_edge( e );
+    return res;
+}
+
+hypergraph_t graph_of( int n, const boost::dynamic_bitset<> &edges )
+{
+    hypergraph_t h( n );
+    for ( auto e = edges.find_first(); e != edges.npos; e = edges.find_next( e ) )
+        h.add_edge( e );
+    return h;
+}
+
+canon_t canonical_form( int n, const boost::dynamic_bitset<> &edges )
+{
+    canon_search s( n, edges );
+
+    partition_t p;
+    p.order.resize( n );
+    std::iota( p.order.begin(), p.order.end(), 0 );
+    p.cell.assign( n, 0 );
+
+    std::vector< int > path;
+    s.search( std::move( p ), path );
+
+    auto hash = hash_bits( n, s.best );
+    auto group_order = s.group_order();
+    return { n, std::move( s.best ), std::move( s.best_lab ), hash, group_order };
+}
+
+canon_t canonical_form( const hypergraph_t &h )
+{
+    return canonical_form( h.n, edge_bitset( h ) );
+}
+
+//// Orbits ///////////////////////////////////////////////////////////////////
+
+hypergraph_t permuted( const hypergraph_t &h, const std::vector< int > &perm )
+{
+    hypergraph_t res( h.n );
+    for ( auto &t : h.edge_list() )
+        res.add_edge( perm[ t[ 0 ] ], perm[ t[ 1 ] ], perm[ t[ 2 ] ] );
+    return res;
+}
+
+std::vector< hypergraph_t > orbit( const hypergraph_t &h, std::size_t cap )
+{
+    std::vector< hypergraph_t > res{ h };
+    std::unordered_set< edge_bits_t > seen{ h.edges };
+
+    std::uint64_t size = factorial( h.n ) / canonical_form( h ).group_order;
+    cap = std::min< std::uint64_t >( cap, size );
+
+    std::vector< int > perm( h.n );
+    std::iota( perm.begin(), perm.end(), 0 );
+    while ( res.size() < cap && std::next_permutation( perm.begin(), perm.end() ) )
+    {
+        auto image = permuted( h, perm );
+        if ( seen.insert( image.edges ).second )
+            res.push_back( std::move( image ) );
+    }
+    return res;
+}
+
+}
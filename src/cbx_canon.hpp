@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <boost/dynamic_bitset.hpp>
+
+#include "cbx_3unihg.hpp"
+
+namespace cbx {
+
+//// Canonical form ///////////////////////////////////////////////////////////
+
+// The canonical representative of the isomorphism class of a 3-uniform
+// hypergraph. Edges are indexed by rank_3, i.e. in the same order as
+// discreture::combinations( n, 3 ) enumerates the triples.
+struct canon_t
+{
+    int n;
+
+    // Edge set of the relabelled hypergraph.
+    boost::dynamic_bitset<> edges;
+
+    // labelling[ v ] is the canonical name of the vertex v.
+    std::vector< int > labelling;
+
+    std::uint64_t hash;
+
+    // The order of the automorphism group of the hypergraph.
+    std::uint64_t group_order;
+};
+
+bool operator==( const canon_t &a, const canon_t &b );
+bool operator!=( const canon_t &a, const canon_t &b );
+
+boost::dynamic_bitset<> edge_bitset( const hypergraph_t &h );
+
+// The inverse of edge_bitset.
+hypergraph_t graph_of( int n, const boost::dynamic_bitset<> &edges );
+
+// Computes the canonical form by partition refinement with vertex
+// invariants, individualising vertices of the first non-singleton cell and
+// pruning the search tree with the automorphisms found on the way.
+canon_t canonical_form( int n, const boost::dynamic_bitset<> &edges );
+
+canon_t canonical_form( const hypergraph_t &h );
+
+//// Orbits ///////////////////////////////////////////////////////////////////
+
+// The hypergraph with every vertex v renamed to perm[ v ].
+hypergraph_t permuted( const hypergraph_t &h, const std::vector< int > &perm );
+
+// The distinct hypergraphs isomorphic to h, found by running through the
+// permutations of the vertices; h itself comes first. Stops once cap of
+// them or all n! / |Aut( h )| are found.
+std::vector< hypergraph_t > orbit( const hypergraph_t &h, std::size_t cap );
+
+}
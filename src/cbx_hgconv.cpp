@@ -0,0 +1,59 @@
+// Converts hypergraph files between the binary form of cbx_hgio and the
+// text form printed by operator<<.
+//
+// cbx_hgconv to-text <in.hg> [out.txt]
+// cbx_hgconv from-text <in.txt> <out.hg>
+// cbx_hgconv show <in.hg> <index>
+
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "cbx_hgio.hpp"
+
+int main( int arc, char** argv )
+{
+    std::string command = arc > 2 ? argv[ 1 ] : "";
+
+    if ( command == "to-text" && arc <= 4 )
+    {
+        cbx::hg_reader_t reader( argv[ 2 ] );
+        std::ofstream file;
+        if ( arc == 4 )
+            file.open( argv[ 3 ] );
+        std::ostream &out = arc == 4 ? file : std::cout;
+        for ( std::size_t i = 0; i < reader.size(); i++ )
+            out << reader.graph( i ) << "\n";
+        return 0;
+    }
+
+    if ( command == "from-text" && arc == 4 )
+    {
+        std::ifstream in( argv[ 2 ] );
+        if ( ! in )
+            throw std::runtime_error( std::string( "cannot read " ) + argv[ 2 ] );
+
+        cbx::hypergraph_t h( 0 );
+        if ( ! cbx::read_text( in, h ) )
+            throw std::runtime_error( "no hypergraphs to convert" );
+        cbx::hg_writer_t writer( argv[ 3 ], h.n );
+        do
+            writer.write( h );
+        while ( cbx::read_text( in, h ) );
+        writer.close();
+        std::cerr << writer.count << " hypergraphs\n";
+        return 0;
+    }
+
+    if ( command == "show" && arc == 4 )
+    {
+        cbx::hg_reader_t reader( argv[ 2 ] );
+        std::cout << reader.graph( std::stoul( argv[ 3 ] ) ) << "\n";
+        return 0;
+    }
+
+    std::cerr << "usage: cbx_hgconv to-text <in.hg> [out.txt]\n"
+                 "       cbx_hgconv from-text <in.txt> <out.hg>\n"
+                 "       cbx_hgconv show <in.hg> <index>\n";
+    return 1;
+}
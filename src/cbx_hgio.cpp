@@ -0,0 +1,221 @@
+#include "cbx_hgio.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "cbx_sim.hpp"
+
+namespace cbx {
+
+//// Binary hypergraph files //////////////////////////////////////////////////
+
+namespace {
+
+void put_header( unsigned char *header, int n, std::uint64_t count )
+{
+    std::memset( header, 0, hg_header_bytes );
+    std::memcpy( header, "CBXH", 4 );
+    header[ 4 ] = 1;
+    header[ 5 ] = n;
+    for ( int b = 0; b < 8; b++ )
+        header[ 8 + b ] = count >> ( 8 * b );
+}
+
+// Below three vertices records are empty, above max_vertices hypergraph_t
+// has no room for the edges.
+bool valid_n( int n )
+{
+    return n >= 3 && n <= max_vertices;
+}
+
+}
+
+hg_writer_t::hg_writer_t( const std::string &path, int n, std::size_t buffer_bytes )
+    : n( n )
+    , path( path )
+    , buffer( std::max( buffer_bytes, record_bytes( n ) ) )
+{
+    if ( ! valid_n( n ) )
+        throw std::invalid_argument( "hg_writer_t: n has to be in 3.." + std::to_string( max_vertices ) );
+
+    file = std::fopen( path.c_str(), "wb" );
+    if ( ! file )
+        throw std::runtime_error( "cannot write " + path );
+
+    unsigned char header[ hg_header_bytes ];
+    put_header( header, n, 0 );
+    if ( std::fwrite( header, 1, hg_header_bytes, file ) != hg_header_bytes )
+    {
+        std::fclose( file );
+        throw std::runtime_error( "cannot write " + path );
+    }
+}
+
+// An unclosed file keeps a zero count and is still read by its size.
+hg_writer_t::~hg_writer_t()
+{
+    if ( ! file )
+        return;
+    try
+    {
+        close();
+    }
+    catch ( const std::exception& )
+    {
+    }
+}
+
+void hg_writer_t::write( const hypergraph_t &h )
+{
+    if ( h.n != n )
+        throw std::invalid_argument( "hg_writer_t: graph on another number of vertices" );
+
+    std::size_t bytes = record_bytes( n );
+    if ( used + bytes > buffer.size() )
+        flush();
+
+    unsigned char *record = buffer.data() + used;
+    std::memset( record, 0, bytes );
+    for ( int e = 0; e < h.slots(); e++ )
+        if ( h.has_edge( e ) )
+            record[ e / 8 ] |= 1 << ( e % 8 );
+
+    used += bytes;
+    count++;
+}
+
+void hg_writer_t::flush()
+{
+    if ( std::fwrite( buffer.data(), 1, used, file ) != used || std::fflush( file ) )
+        throw std::runtime_error( "cannot write " + path );
+    used = 0;
+}
+
+// The file is closed even if writing fails; the count only goes into the
+// header once all records are written.
+void hg_writer_t::close()
+{
+    unsigned char header[ hg_header_bytes ];
+    put_header( header, n, count );
+
+    bool ok = std::fwrite( buffer.data(), 1, used, file ) == used
+           && std::fseek( file, 0, SEEK_SET ) == 0
+           && std::fwrite( header, 1, hg_header_bytes, file ) == hg_header_bytes;
+    ok = std::fclose( file ) == 0 && ok;
+    file = nullptr;
+    used = 0;
+    if ( ! ok )
+        throw std::runtime_error( "cannot write " + path );
+}
+
+hg_reader_t::hg_reader_t( const std::string &path )
+{
+    int fd = open( path.c_str(), O_RDONLY );
+    if ( fd < 0 )
+        throw std::runtime_error( "cannot read " + path );
+
+    struct stat st;
+    if ( fstat( fd, &st ) != 0 )
+    {
+        ::close( fd );
+        throw std::runtime_error( "cannot read " + path );
+    }
+    length = st.st_size;
+    if ( length >= hg_header_bytes )
+    {
+        void *mapped = mmap( nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0 );
+        if ( mapped != MAP_FAILED )
+            data = static_cast< const unsigned char* >( mapped );
+    }
+    ::close( fd );
+
+    // The destructor does not run if the constructor throws.
+    auto fail = [ & ]( const std::string &what )
+    {
+        if ( data )
+            munmap( const_cast< unsigned char* >( data ), length );
+        data = nullptr;
+        throw std::runtime_error( what + path );
+    };
+
+    if ( ! data || std::memcmp( data, "CBXH", 4 ) != 0 || data[ 4 ] != 1
+      || ! valid_n( data[ 5 ] ) )
+        fail( "not a hypergraph file " );
+
+    n = data[ 5 ];
+    for ( int b = 0; b < 8; b++ )
+        count |= std::uint64_t( data[ 8 + b ] ) << ( 8 * b );
+    if ( count == 0 )
+        count = ( length - hg_header_bytes ) / record_bytes( n );
+    if ( count > ( length - hg_header_bytes ) / record_bytes( n ) )
+        fail( "truncated hypergraph file " );
+}
+
+hg_reader_t::~hg_reader_t()
+{
+    if ( data )
+        munmap( const_cast< unsigned char* >( data ), length );
+}
+
+hypergraph_t hg_reader_t::graph( std::size_t index ) const
+{
+    if ( index >= count )
+        throw std::out_of_range( "hg_reader_t: no graph " + std::to_string( index ) );
+
+    const unsigned char *record = data + hg_header_bytes + index * record_bytes( n );
+    hypergraph_t h( n );
+    for ( int e = 0; e < h.slots(); e++ )
+        if ( ( record[ e / 8 ] >> ( e % 8 ) ) & 1 )
+            h.add_edge( e );
+    return h;
+}
+
+//// Text form ////////////////////////////////////////////////////////////////
+
+bool read_text( std::istream &is, hypergraph_t &h )
+{
+    std::string word;
+    if ( ! ( is >> word ) )
+        return false;
+
+    auto fail = [ & ]()
+    {
+        throw std::runtime_error( "malformed hypergraph near " + word );
+    };
+
+    if ( word.rfind( "Hypergraph[", 0 ) != 0 || word.back() != ']' )
+        fail();
+    int n = -1;
+    try { n = std::stoi( word.substr( 11, word.size() - 12 ) ); }
+    catch ( const std::logic_error& ) {}
+    if ( n < 0 || n > max_vertices )
+        fail();
+    h = hypergraph_t( n );
+
+    char c;
+    if ( ! ( is >> c ) || c != '{' )
+        fail();
+    while ( is >> c && c == '{' )
+    {
+        int i, j, k;
+        char comma1, comma2, close;
+        if ( ! ( is >> i >> comma1 >> j >> comma2 >> k >> close )
+          || comma1 != ',' || comma2 != ',' || close != '}' )
+            fail();
+        if ( std::min( { i, j, k } ) < 0 || std::max( { i, j, k } ) >= n
+          || i == j || j == k || i == k )
+            fail();
+        h.add_edge( i, j, k );
+    }
+    if ( c != '}' )
+        fail();
+    return true;
+}
+
+}
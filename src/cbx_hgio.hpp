@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "cbx_3unihg.hpp"
+
+namespace cbx {
+
+//// Binary hypergraph files //////////////////////////////////////////////////
+
+// A file of 3-uniform hypergraphs on n vertices, a 3-uniform graph6 of
+// sorts. After a 16 byte header
+//
+//   "CBXH" <version 1> <n> <2 bytes zero> <count, 8 bytes little endian>
+//
+// every graph takes record_bytes( n ) bytes: its C( n, 3 ) edge bits in
+// rank_3 order, the edge of rank e in bit e % 8 of byte e / 8. A count of
+// zero means the writer did not finish, the records are counted by the file
+// size then. n is in 3..max_vertices, the writer and the reader reject
+// anything else.
+
+constexpr std::size_t hg_header_bytes = 16;
+
+constexpr std::size_t record_bytes( int n ) { return ( choose( n, 3 ) + 7 ) / 8; }
+
+// Appends graphs to a new file through a buffer of buffer_bytes.
+struct hg_writer_t
+{
+    hg_writer_t( const std::string &path, int n, std::size_t buffer_bytes = 1 << 20 );
+    ~hg_writer_t();
+
+    hg_writer_t( const hg_writer_t& ) = delete;
+    hg_writer_t& operator=( const hg_writer_t& ) = delete;
+
+    void write( const hypergraph_t &h );
+
+    // Hands the buffer to the file, the graphs written so far survive a
+    // crash afterwards.
+    void flush();
+
+    // Flushes and records the count in the header, throws if any of it
+    // cannot be written.
+    void close();
+
+    int n;
+    std::uint64_t count = 0;
+
+    private:
+    std::FILE *file;
+    std::string path;
+    std::vector< unsigned char > buffer;
+    std::size_t used = 0;
+};
+
+// Maps a file written by hg_writer_t, graphs are decoded on access.
+struct hg_reader_t
+{
+    explicit hg_reader_t( const std::string &path );
+    ~hg_reader_t();
+
+    hg_reader_t( const hg_reader_t& ) = delete;
+    hg_reader_t& operator=( const hg_reader_t& ) = delete;
+
+    std::size_t size() const { return count; }
+
+    hypergraph_t graph( std::size_t index ) const;
+
+    int n;
+
+    private:
+    const unsigned char *data = nullptr;
+    std::size_t length = 0;
+    std::size_t count = 0;
+};
+
+//// Text form ////////////////////////////////////////////////////////////////
+
+// Reads one hypergraph printed by operator<<, false at the end of the input.
+bool read_text( std::istream &is, hypergraph_t &h );
+
+}
@@ -1 +1,43 @@
 #include "cbx_sim.hpp" 
+
+namespace cbx {
+
+//// Permutation ranks ////////////////////////////////////////////////////////
+
+std::uint64_t perm_rank( const std::vector< int > &perm )
+{
+    int n = perm.size();
+    if ( n > max_factorial_n )
+        throw std::out_of_range( "perm_rank: permutation too long" );
+
+    // Digit i of the Lehmer code counts the smaller values right of i.
+    std::uint64_t rank = 0;
+    for ( int i = 0; i < n; i++ )
+    {
+        int smaller = 0;
+        for ( int j = i + 1; j < n; j++ )
+            smaller += perm[ j ] < perm[ i ];
+        rank += smaller * factorial( n - 1 - i );
+    }
+    return rank;
+}
+
+std::vector< int > perm_unrank( int n, std::uint64_t rank )
+{
+    if ( n > max_factorial_n || rank >= factorial( n ) )
+        throw std::out_of_range( "perm_unrank: no such permutation" );
+
+    std::vector< int > unused( n ), perm;
+    for ( int v = 0; v < n; v++ )
+        unused[ v ] = v;
+    for ( int i = n - 1; i >= 0; i-- )
+    {
+        std::uint64_t digit = rank / factorial( i );
+        rank %= factorial( i );
+        perm.push_back( unused[ digit ] );
+        unused.erase( unused.begin() + digit );
+    }
+    return perm;
+}
+
+}
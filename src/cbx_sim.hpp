@@ -1,19 +1,148 @@
 #pragma once
 
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
 namespace cbx {
 
-constexpr int choose( int n, int k ) 
+using uint128_t = unsigned __int128;
+
+//// Binomials ////////////////////////////////////////////////////////////////
+
+// Pascal's triangle as far as every entry fits 64 bits, C( 68, 34 ) is the
+// first which does not.
+constexpr int max_pascal_n = 67;
+
+struct pascal_table_t
 {
-    int nom = 1; 
-    int den = 1;
+    std::uint64_t rows[ max_pascal_n + 1 ][ max_pascal_n + 1 ] = {};
 
-    int rounds = k;
-    for ( int i = 0; i < rounds; i++ )
+    constexpr pascal_table_t()
     {
-        nom *= n--;
-        den *= k--;
+        for ( int n = 0; n <= max_pascal_n; n++ )
+        {
+            rows[ n ][ 0 ] = 1;
+            for ( int k = 1; k <= n; k++ )
+                rows[ n ][ k ] = rows[ n - 1 ][ k - 1 ] + rows[ n - 1 ][ k ];
+        }
     }
-    return nom / den;
+};
+
+inline constexpr pascal_table_t pascal{};
+
+// C( n, k ) in 128 bits, exact up to max_wide_n. Runs along the rows of
+// Pascal's triangle up to column min( k, n - k ), whose entries never exceed
+// the result.
+constexpr int max_wide_n = 130;
+
+constexpr uint128_t binomial_wide( int n, int k )
+{
+    if ( k < 0 || k > n )
+        return 0;
+    if ( n > max_wide_n )
+        throw std::out_of_range( "binomial_wide: n too large" );
+    if ( k > n - k )
+        k = n - k;
+
+    uint128_t row[ max_wide_n / 2 + 1 ] = { 1 };
+    for ( int m = 1; m <= n; m++ )
+        for ( int j = m < k ? m : k; j > 0; j-- )
+            row[ j ] += row[ j - 1 ];
+    return row[ k ];
+}
+
+// C( n, k ), 0 unless 0 <= k <= n; throws if it does not fit 64 bits.
+constexpr std::uint64_t binomial( int n, int k )
+{
+    if ( k < 0 || k > n )
+        return 0;
+    if ( n <= max_pascal_n )
+        return pascal.rows[ n ][ k ];
+
+    uint128_t wide = binomial_wide( n, k );
+    if ( wide > std::numeric_limits< std::uint64_t >::max() )
+        throw std::overflow_error( "binomial: C( n, k ) exceeds 64 bits" );
+    return std::uint64_t( wide );
+}
+
+// binomial for the sizes used as indices and loop bounds.
+constexpr int choose( int n, int k )
+{
+    std::uint64_t c = binomial( n, k );
+    if ( c > std::uint64_t( std::numeric_limits< int >::max() ) )
+        throw std::overflow_error( "choose: C( n, k ) exceeds int" );
+    return int( c );
+}
+
+static_assert( choose( 16, 3 ) == 560 && choose( 3, 4 ) == 0 );
+static_assert( binomial( 67, 33 ) == 14226520737620288370ull );
+static_assert( binomial_wide( 68, 34 ) == 2 * uint128_t( binomial( 67, 33 ) ) );
+
+//// Factorials ///////////////////////////////////////////////////////////////
+
+constexpr int max_factorial_n = 20;
+constexpr int max_factorial_wide_n = 34;
+
+constexpr uint128_t factorial_wide( int n )
+{
+    if ( n < 0 || n > max_factorial_wide_n )
+        throw std::out_of_range( "factorial_wide: n out of range" );
+    uint128_t res = 1;
+    for ( int i = 2; i <= n; i++ )
+        res *= i;
+    return res;
+}
+
+constexpr std::uint64_t factorial( int n )
+{
+    if ( n > max_factorial_n )
+        throw std::overflow_error( "factorial: n! exceeds 64 bits" );
+    return std::uint64_t( factorial_wide( n ) );
 }
 
+static_assert( factorial( 0 ) == 1 && factorial( 20 ) == 2432902008176640000ull );
+
+//// Permutation ranks ////////////////////////////////////////////////////////
+
+// Position of a permutation of 0, ..., n - 1 in lexicographic order, the
+// order of std::next_permutation, through its Lehmer code. n is at most
+// max_factorial_n.
+std::uint64_t perm_rank( const std::vector< int > &perm );
+
+// The permutation of 0, ..., n - 1 with the given rank.
+std::vector< int > perm_unrank( int n, std::uint64_t rank );
+
+//// Triples //////////////////////////////////////////////////////////////////
+
+// Position of the triple i < j < k in the colexicographic order, which is
+// the order discreture::combinations( n, 3 ) enumerates triples in. The
+// rank does not depend on n.
+constexpr int rank_3( int i, int j, int k )
+{
+    return choose( i, 1 ) + choose( j, 2 ) + choose( k, 3 );
+}
+
+using triple_t = std::array< int, 3 >;
+
+// The triple i < j < k of the given rank, by the combinatorial number
+// system: k is the largest with C( k, 3 ) <= rank and so on.
+constexpr triple_t unrank_3( int rank )
+{
+    int k = 2;
+    while ( choose( k + 1, 3 ) <= rank )
+        k++;
+    rank -= choose( k, 3 );
+    int j = 1;
+    while ( choose( j + 1, 2 ) <= rank )
+        j++;
+    rank -= choose( j, 2 );
+    return { rank, j, k };
+}
+
+static_assert( rank_3( 0, 1, 2 ) == 0 && rank_3( 1, 3, 4 ) == 8 );
+static_assert( unrank_3( 8 )[ 0 ] == 1 && unrank_3( 8 )[ 1 ] == 3 && unrank_3( 8 )[ 2 ] == 4 );
+
 }
@@ -0,0 +1,754 @@
+#include "finder.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <chrono>
+#include <cstdlib>
+#include <numeric>
+#include <sstream>
+#include <type_traits>
+
+#include "kck_log.hpp"
+#include "kck_utils.hpp"
+#include "cbx_utils.hpp"
+
+namespace kck {
+
+std::ostream& operator<<( std::ostream& os, const std::vector< int > &v )
+{
+    os << "[";
+    for ( std::size_t i = 0; i < v.size(); i++ )
+    {
+        os << v[ i ];
+        if ( i < v.size() - 1 ) os << ", ";
+    }
+    return os << "]";
+}
+
+std::ostream& operator<<( std::ostream& os, const std::set< int > &s )
+{
+    os << "{";
+    for ( auto it = s.begin(); it != s.end(); it++ )
+    {
+        if ( it != s.begin() ) os << ", ";
+        os << *it;
+    }
+    return os << "}";
+}
+
+}
+
+using namespace kck;
+
+//// Variables ////////////////////////////////////////////////////////////////
+
+lit_t labeler( int i ) { return { { 'X', { i } }, true }; }
+
+formula_ptr< lit_t > llit( var_t v, bool pos )
+{
+    return forms::f_lit( { v, pos } );
+}
+
+var_t arc_color( int i, int j, int color )
+{
+    return { 'c', { i, j, color } };
+}
+
+var_t edge_present( int edge_index )
+{
+    return { 'e', { edge_index } };
+}
+
+//// Coloring formula /////////////////////////////////////////////////////////
+
+cnf_t< lit_t > cnf_triangle( const palette_t &palette
+                           , int i, int j, int k, int edge_index
+                           , cnf_builder< lit_t > &builder )
+{
+    assert( i < j && j < k );
+    forms::or_t triangle_cond;
+    // Either the edge is not present
+    triangle_cond.push( llit( edge_present( edge_index ), false ) );
+    // Or it needs at least one of the patterns
+    for ( auto &p : palette )
+        triangle_cond.push( forms::f_and(
+            { llit( arc_color( i, j, p[ 0 ] ), true )
+            , llit( arc_color( j, k, p[ 1 ] ), true )
+            , llit( arc_color( i, k, p[ 2 ] ), true ) } ) );
+    return triangle_cond.to_cnf( builder );
+}
+
+cnf_t< lit_t > cnf_triangles( const palette_t &palette, int n, cnf_builder< lit_t > &builder )
+{
+    cnf_t< lit_t > cnf;
+
+    int edge_index = 0;
+    for ( auto &&x : discreture::combinations( n, 3 ) )
+    {
+        int i = x[ 0 ], j = x[ 1 ], k = x[ 2 ];
+        add_to( cnf, cnf_triangle( palette, i, j, k, edge_index, builder ) );
+        edge_index++;
+    }
+    return cnf;
+}
+
+void cnf_arc_coloring( int i, int j, int colors, cnf_t< lit_t > &cnf )
+{
+    assert( i < j );
+
+    // each edge gets at least one color
+    cnf_clause_t< lit_t > clause;
+    for ( int c = 0; c < colors; c++ )
+        clause.push_back( { arc_color( i, j, c ), true } );
+    cnf.push_back( clause );
+
+    // each edge gets no more than two colors
+    for ( auto &&cc : discreture::combinations( colors, 2 ) ) {
+        if ( cc[ 0 ] == cc[ 1 ] ) continue;
+        cnf.push_back( { { arc_color( i, j, cc[ 0 ] ), false }
+                       , { arc_color( i, j, cc[ 1 ] ), false } } );
+    }
+}
+
+cnf_t< lit_t > cnf_coloring( int n, int colors )
+{
+    cnf_t< lit_t > cnf;
+    for ( auto &&x : discreture::combinations( n, 2 ) )
+        cnf_arc_coloring( x[ 0 ], x[ 1 ], colors, cnf );
+    return cnf;
+}
+
+cnf_t< lit_t > build_coloring_cnf_vertex( int v
+                                        , int colors
+                                        , const palette_t &palette
+                                        , cnf_builder< lit_t > &builder )
+{
+    cnf_t< lit_t > cnf;
+    for ( int i = 0; i < v; i++ )
+        cnf_arc_coloring( i, v, colors, cnf );
+
+    // The edges of v vertices keep their indices on v + 1 vertices, the
+    // new ones come last.
+    int edge_index = 0;
+    for ( auto &&x : discreture::combinations( v + 1, 3 ) )
+    {
+        if ( x[ 2 ] == v )
+            add_to( cnf, cnf_triangle( palette, x[ 0 ], x[ 1 ], v, edge_index, builder ) );
+        edge_index++;
+    }
+    return cnf;
+}
+
+cnf_t< lit_t > build_coloring_cnf( 
+    int n, 
+    int colors, 
+    const palette_t &palette, 
+    cnf_builder< lit_t > &builder )
+{
+    cnf_t< lit_t > cnf;
+    add_to( cnf, cnf_coloring( n, colors ) );
+    add_to( cnf, cnf_triangles( palette, n, builder ) );
+    return cnf;
+}
+
+cnf_t< lit_t > build_coloring_cnf( int n, int colors, const palette_t &palette )
+{
+    cnf_builder< lit_t > builder( labeler );
+    return build_coloring_cnf( n, colors, palette, builder );
+}
+
+//// Blue coloring ////////////////////////////////////////////////////////////
+
+palette_t blue_palette = { { 1, 2, 3 }, { 4, 1, 5 }, { 6, 7, 1 } };
+
+
+std::ostream& operator<<( std::ostream& os, const lat_hypergraph_t& h )
+{
+    return os << h.graph;
+}
+
+void lat_hypergraph_t::set_order( std::shared_ptr< const lat_order_t > order )
+{
+    this->order = order;
+    color_vars.clear();
+    if ( ! order || ! order->uses_model() )
+        return;
+
+    palette_colors = blue_colors;
+    for ( auto &p : blue_palette )
+        for ( int c : p )
+            palette_colors = std::max( palette_colors, c + 1 );
+
+    color_vars.assign( n * n * palette_colors, 0 );
+    for ( auto &a : discreture::combinations( n, 2 ) )
+        for ( int c = 0; c < palette_colors; c++ )
+        {
+            auto it = translation.left.find( arc_color( a[ 0 ], a[ 1 ], c ) );
+            if ( it != translation.left.end() )
+                color_vars[ cbx::adj_i( n, a[ 0 ], a[ 1 ] ) * palette_colors + c ] = it->second;
+        }
+}
+
+int lat_hypergraph_t::branch_edge( int level )
+{
+    if ( ! order )
+        return level;
+
+    // Levels at and below this one belong to nodes the traversal left.
+    while ( int( branched.size() ) > level )
+    {
+        decided[ branched.back() ] = false;
+        branched.pop_back();
+    }
+
+    int edge = order->pick( *this, level );
+    assert( ! decided[ edge ] );
+    branched.push_back( edge );
+    decided[ edge ] = true;
+    return edge;
+}
+
+void lat_hypergraph_t::read_arc_colors()
+{
+    arc_colors.assign( n * n, 0 );
+    for ( int a = 0; a < n * n; a++ )
+        for ( int c = 0; c < palette_colors; c++ )
+        {
+            int var = color_vars[ a * palette_colors + c ];
+            if ( var && blue_solver.val( var ) > 0 )
+                arc_colors[ a ] |= 1u << c;
+        }
+}
+
+//// Branching orders /////////////////////////////////////////////////////////
+
+namespace {
+
+struct index_order_t : lat_order_t
+{
+    int pick( const lat_hypergraph_t&, int level ) const override
+    {
+        return level;
+    }
+};
+
+// The undecided edge with the smallest score, the first one on ties.
+template < typename score_t >
+int argmin_undecided( const lat_hypergraph_t &h, score_t score )
+{
+    int best = -1;
+    int best_score = 0;
+    for ( int e = 0; e < h.graph.slots(); e++ )
+    {
+        if ( h.decided[ e ] )
+            continue;
+        int s = score( e );
+        if ( best < 0 || s < best_score )
+        {
+            best = e;
+            best_score = s;
+        }
+    }
+    return best;
+}
+
+struct degree_order_t : lat_order_t
+{
+    int pick( const lat_hypergraph_t &h, int ) const override
+    {
+        std::vector< int > degree( h.n );
+        for ( int v = 0; v < h.n; v++ )
+            degree[ v ] = h.graph.degree( v );
+
+        return argmin_undecided( h, [ & ]( int e )
+        {
+            auto [ i, j, k ] = cbx::triple_of[ e ];
+            return - ( degree[ i ] + degree[ j ] + degree[ k ] );
+        } );
+    }
+};
+
+// The arcs of the edges in the graph are committed to their colors in the
+// last blue model, the others may still take any color. A pattern remains
+// compatible with a triangle if it agrees with the committed arcs.
+struct palette_order_t : lat_order_t
+{
+    int pick( const lat_hypergraph_t &h, int ) const override
+    {
+        if ( h.arc_colors.empty() )
+            return argmin_undecided( h, []( int ) { return 0; } );
+
+        std::vector< unsigned > committed( h.n * h.n, 0 );
+        for ( auto [ i, j, k ] : h.graph.edge_list() )
+        {
+            committed[ cbx::adj_i( h.n, i, j ) ] = ~0u;
+            committed[ cbx::adj_i( h.n, j, k ) ] = ~0u;
+            committed[ cbx::adj_i( h.n, i, k ) ] = ~0u;
+        }
+
+        auto allows = [ & ]( int i, int j, int c )
+        {
+            int a = cbx::adj_i( h.n, i, j );
+            return ! committed[ a ] || ( h.arc_colors[ a ] >> c ) & 1;
+        };
+
+        return argmin_undecided( h, [ & ]( int e )
+        {
+            auto [ i, j, k ] = cbx::triple_of[ e ];
+            int compatible = 0;
+            for ( auto &p : blue_palette )
+                compatible += allows( i, j, p[ 0 ] ) && allows( j, k, p[ 1 ] )
+                           && allows( i, k, p[ 2 ] );
+            return compatible;
+        } );
+    }
+
+    bool uses_model() const override { return true; }
+};
+
+// The edges on a level are those of the levels above it in a static order,
+// so the order is just looked up.
+struct static_order_t : lat_order_t
+{
+    std::vector< int > edges;
+
+    int pick( const lat_hypergraph_t&, int level ) const override
+    {
+        return edges[ level ];
+    }
+};
+
+// The edges by the number of lemmas of the blue solver their variable
+// occurs in, most first; index order for equal counts.
+std::vector< int > lemma_order( const lat_hypergraph_t &h )
+{
+    std::map< int, int > edge_of;
+    for ( std::size_t e = 0; e < h.edge_vars.size(); e++ )
+        edge_of[ h.edge_vars[ e ] ] = e;
+
+    std::vector< int > occurrences( h.edge_vars.size(), 0 );
+    for ( auto &clause : h.lemmas->clauses )
+        for ( int lit : clause )
+        {
+            auto it = edge_of.find( std::abs( lit ) );
+            if ( it != edge_of.end() )
+                occurrences[ it->second ]++;
+        }
+
+    std::vector< int > order( h.edge_vars.size() );
+    std::iota( order.begin(), order.end(), 0 );
+    std::stable_sort( order.begin(), order.end(), [ & ]( int a, int b )
+    {
+        return occurrences[ a ] > occurrences[ b ];
+    } );
+    return order;
+}
+
+}
+
+std::shared_ptr< const lat_order_t > make_lat_order( const std::string &name
+                                                   , const lat_hypergraph_t &h )
+{
+    if ( name == "index" )
+        return std::make_shared< index_order_t >();
+    if ( name == "degree" )
+        return std::make_shared< degree_order_t >();
+    if ( name == "palette" )
+        return std::make_shared< palette_order_t >();
+    if ( name == "lemmas" )
+    {
+        if ( ! h.lemmas )
+            throw std::runtime_error( "the lemmas order needs --lemmas" );
+        auto order = std::make_shared< static_order_t >();
+        order->edges = lemma_order( h );
+        return order;
+    }
+    throw std::runtime_error( "unknown lattice order " + name );
+}
+
+//// Red coloring /////////////////////////////////////////////////////////////
+
+
+namespace {
+
+// Whether no arc serves as left, right and top edge at once once the
+// vertices are renamed by perm.
+bool perm_colorable( int n, const cbx::edge_bits_t &edges, const int *perm )
+{
+    std::vector< unsigned int > roles( n * n, 0 );
+
+    for ( int e = 0; e < cbx::choose( n, 3 ); e++ )
+    {
+        if ( ! edges[ e ] )
+            continue;
+
+        auto [ a, b, c ] = cbx::triple_of[ e ];
+        int i = perm[ a ], j = perm[ b ], k = perm[ c ];
+        cbx::sort_i( i, j, k );
+        assert( i < j && j < k );
+        // The arc serves as left edge
+        roles[ cbx::adj_i( n, i, j ) ] |= 1;
+        // The arc serves as right edge
+        roles[ cbx::adj_i( n, j, k ) ] |= 2;
+        // The arc serves as top edge
+        roles[ cbx::adj_i( n, i, k ) ] |= 4;
+    }
+
+    for ( auto v : roles )
+        // If any arc serves as both left, top, right
+        if ( v == 7 )
+            return false;
+    return true;
+}
+
+// perm_colorable for a fixed n, stopping at the first arc with all roles.
+template < int n >
+bool perm_colorable_n( const cbx::edge_bits_t &edges, const int *perm )
+{
+    constexpr int slots = cbx::choose( n, 3 );
+    std::array< unsigned char, n * n > roles = {};
+
+    for ( int e = 0; e < slots; e++ )
+    {
+        if ( ! edges[ e ] )
+            continue;
+
+        auto [ a, b, c ] = cbx::triple_of[ e ];
+        int i = perm[ a ], j = perm[ b ], k = perm[ c ];
+        if ( i > j ) std::swap( i, j );
+        if ( j > k ) std::swap( j, k );
+        if ( i > j ) std::swap( i, j );
+        if ( ( roles[ cbx::adj_i< n >( i, j ) ] |= 1 ) == 7
+          || ( roles[ cbx::adj_i< n >( j, k ) ] |= 2 ) == 7
+          || ( roles[ cbx::adj_i< n >( i, k ) ] |= 4 ) == 7 )
+            return false;
+    }
+    return true;
+}
+
+template < int n >
+bool find_perm_coloring_n( const cbx::edge_bits_t &edges, std::vector< int > *found )
+{
+    std::array< int, n > perm;
+    std::iota( perm.begin(), perm.end(), 0 );
+    do
+    {
+        if ( perm_colorable_n< n >( edges, perm.data() ) )
+        {
+            if ( found )
+                found->assign( perm.begin(), perm.end() );
+            return true;
+        }
+    } while ( std::next_permutation( perm.begin(), perm.end() ) );
+    return false;
+}
+
+bool is_fixed_n( int n )
+{
+    return n >= min_fixed_n && n <= max_fixed_n;
+}
+
+// Calls f( std::integral_constant< int, n >() ), n has to be fixed.
+template < typename fun_t >
+bool with_fixed_n( int n, fun_t f )
+{
+    switch ( n )
+    {
+        case 4: return f( std::integral_constant< int, 4 >() );
+        case 5: return f( std::integral_constant< int, 5 >() );
+        case 6: return f( std::integral_constant< int, 6 >() );
+        case 7: return f( std::integral_constant< int, 7 >() );
+        case 8: return f( std::integral_constant< int, 8 >() );
+        case 9: return f( std::integral_constant< int, 9 >() );
+        case 10: return f( std::integral_constant< int, 10 >() );
+    }
+    throw std::logic_error( "with_fixed_n: " + std::to_string( n ) + " is not compiled" );
+}
+
+static_assert( max_fixed_n == 10, "with_fixed_n lists the fixed sizes" );
+
+}
+
+bool is_perm_colorable( const lat_hypergraph_t &h, const std::vector< int > &perm )
+{
+    KCK_PROF_SCOPE( "is_perm_colorable" );
+    if ( ! is_fixed_n( h.n ) )
+        return perm_colorable( h.n, h.graph.edges, perm.data() );
+
+    return with_fixed_n( h.n, [ & ]( auto n )
+    {
+        return perm_colorable_n< decltype( n )::value >( h.graph.edges, perm.data() );
+    } );
+}
+
+bool find_perm_coloring( const lat_hypergraph_t &h, std::vector< int > *perm )
+{
+    if ( is_fixed_n( h.n ) )
+        return with_fixed_n( h.n, [ & ]( auto n )
+        {
+            return find_perm_coloring_n< decltype( n )::value >( h.graph.edges, perm );
+        } );
+
+    for ( auto &&p : discreture::permutations( h.n ) )
+        if ( perm_colorable( h.n, h.graph.edges, p.data() ) )
+        {
+            if ( perm )
+                perm->assign( p.begin(), p.end() );
+            return true;
+        }
+    return false;
+}
+
+bool is_r_uncolorable( lat_hypergraph_t &h )
+{
+    return ! find_perm_coloring( h );
+}
+
+coloring_t get_coloring_solution( const lat_hypergraph_t &h
+                                , int colors
+                                , sat_solver_t &solver )
+{
+    coloring_t coloring;
+
+    int n = h.n;
+
+    const bimap< var_t, int > &translation = h.translation;
+
+    for ( auto &a : discreture::combinations( n, 2 ) )
+        for ( int c = 0; c < colors; c++ )
+            if ( solver.val( translation.left.at( arc_color( a[ 0 ], a[ 1 ], c ) ) ) > 0 )
+                coloring.insert( { { a[ 0 ], a[ 1 ] }, c } );
+
+    return coloring;
+}
+
+void print_graph( lat_hypergraph_t &h )
+{
+    h.solutions.push_back( h.graph );
+
+    std::ostringstream os;
+    os << h.graph << "\n";
+
+    int res = h.solve_blue();
+    assert( res == SAT_Y );
+
+    coloring_t coloring = get_coloring_solution( h, 7, h.blue_solver );
+
+    //show( std::cout, h.blue_orig, true );
+
+    for ( const auto &[ key, item ] : coloring )
+    {
+        os << key << "->" << item << "\n";
+    }
+    log_write( std::move( os ).str() );
+}
+
+bool is_b_uncolorable( lat_hypergraph_t &h )
+{
+    if ( h.counter_graph_entered % 100000 == 0 )
+    {
+        trace( "sts", field( "visited", h.counter_graph_entered )
+             , field( "blue_colorable", h.counter_blue_colorable ), h.graph );
+    }
+    h.counter_graph_entered++;
+
+    //trace( "edges", h.graph );
+
+    int res = h.solve_blue();
+    if ( res == SAT_U ) throw std::runtime_error( "sat does not know" );
+
+    if ( res == SAT_Y )
+        h.counter_blue_colorable ++;
+
+    return res == SAT_N;
+}
+
+//// Witness minimization ///////////////////////////////////////////////////
+
+bool red_check_t::is_r_uncolorable( lat_hypergraph_t &h )
+{
+    checks++;
+    for ( std::size_t i = 0; i < cache.size(); i++ )
+        if ( is_perm_colorable( h, cache[ i ] ) )
+        {
+            cache_hits++;
+            // Move to front, the last colorings tend to work again.
+            std::rotate( cache.begin(), cache.begin() + i, cache.begin() + i + 1 );
+            return false;
+        }
+
+    std::vector< int > perm;
+    if ( find_perm_coloring( h, &perm ) )
+    {
+        cache.insert( cache.begin(), std::move( perm ) );
+        return false;
+    }
+    return true;
+}
+
+namespace {
+
+struct quickxplain
+{
+    lat_hypergraph_t &h;
+    red_check_t red;
+
+    bool uncolorable( const std::vector< int > &edges )
+    {
+        h.graph = cbx::hypergraph_t( h.n );
+        for ( int e : edges )
+            h.add_edge( e );
+        return red.is_r_uncolorable( h );
+    }
+
+    // A minimal subset X of candidates such that base and X are red
+    // uncolorable, given that base and all candidates are.
+    std::vector< int > go( const std::vector< int > &base
+                         , bool base_changed
+                         , const std::vector< int > &candidates )
+    {
+        if ( base_changed && uncolorable( base ) )
+            return {};
+        if ( candidates.size() == 1 )
+            return candidates;
+
+        auto middle = candidates.begin() + candidates.size() / 2;
+        std::vector< int > first( candidates.begin(), middle );
+        std::vector< int > second( middle, candidates.end() );
+
+        std::vector< int > with_first = base;
+        with_first.insert( with_first.end(), first.begin(), first.end() );
+        auto second_part = go( with_first, true, second );
+
+        std::vector< int > with_second = base;
+        with_second.insert( with_second.end(), second_part.begin(), second_part.end() );
+        auto first_part = go( with_second, ! second_part.empty(), first );
+
+        first_part.insert( first_part.end(), second_part.begin(), second_part.end() );
+        return first_part;
+    }
+};
+
+}
+
+const cbx::hypergraph_t& minimize_witness( lat_hypergraph_t &h, minimize_stats_t *stats )
+{
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector< int > edges;
+    for ( int e = 0; e < h.graph.slots(); e++ )
+        if ( h.graph.has_edge( e ) )
+            edges.push_back( e );
+
+    quickxplain qx{ h, {} };
+    if ( edges.empty() || ! qx.uncolorable( edges ) )
+        throw std::runtime_error( "minimize_witness: the graph is red colorable" );
+
+    auto minimal = qx.go( {}, false, edges );
+
+    h.graph = cbx::hypergraph_t( h.n );
+    for ( int e : minimal )
+        h.add_edge( e );
+
+    if ( stats )
+    {
+        std::chrono::duration< double > took = std::chrono::steady_clock::now() - start;
+        stats->red_checks = qx.red.checks;
+        stats->cache_hits = qx.red.cache_hits;
+        stats->seconds = took.count();
+    }
+
+    if ( h.solve_blue() != SAT_Y )
+        throw std::runtime_error( "minimize_witness: the graph is not blue colorable" );
+    return h.graph;
+}
+
+cbx::hypergraph_t minimize_witness( const cbx::hypergraph_t &h, minimize_stats_t *stats )
+{
+    lat_hypergraph_t lat( h.n );
+    lat.graph = h;
+    return minimize_witness( lat, stats );
+}
+
+//// Red formula ////////////////////////////////////////////////////////////////
+
+var_t role_label( int p, int i, int j, int role )
+{
+    return { 'f', { p, i, j, role } };
+}
+
+forms::form_p red_uncolor_formula( int n )
+{
+
+    // Each ordering of the vertices needs one arc, which is uncolorable.
+    forms::and_t all_orderings_uncolorable;
+
+    int perm_index = 0;
+
+    for ( auto &&p : discreture::permutations( n ) )
+    {
+
+        // Go through the edges and label roles of the arcs.  
+        forms::and_t roles;
+
+        int edge_index = 0;
+
+        for ( auto &&c : discreture::combinations( n, 3 ) )
+        {
+            // edge_index represents the edge i, j, k 
+            // if edge with edge_index is on, ijk is in the graph
+            int pi = p[ c[ 0 ] ], pj = p[ c[ 1 ] ], pk = p[ c[ 2 ] ];
+
+            // This makes sure, we are adding the arcs in correct order 
+            // *with respect to the order of the permuted graph*. This 
+            // sorting is precisely the thing, which changes the order 
+            // of the graph. 
+            cbx::sort_i( pi, pj, pk );
+            assert( pi < pj && pj < pk );
+
+            roles.push( 
+                forms::f_imp( llit( edge_present( edge_index ), true )
+                            , forms::f_and( { llit( role_label( perm_index, pi, pj, 1 )
+                                                  , true )
+                                            , llit( role_label( perm_index, pj, pk, 2 )
+                                                  , true )
+                                            , llit( role_label( perm_index, pi, pk, 3 )
+                                                  , true ) } ) ) );
+            edge_index++;
+        }
+
+        // A problem happens, if at least one arcs has all three roles.
+        forms::or_t problem;
+        for ( auto &&c : discreture::combinations( n, 2 ) )
+        {
+            int i = c[ 0 ], j = c[ 1 ];
+            assert( i < j );
+            problem.push( forms::f_or( { llit( role_label( perm_index, i, j, 1 )
+                                             , true )
+                                       , llit( role_label( perm_index, i, j, 1 )
+                                             , true )
+                                       , llit( role_label( perm_index, i, j, 1 )
+                                             , true ) } ) );
+        }
+
+        all_orderings_uncolorable.push( roles );
+        all_orderings_uncolorable.push( problem );
+
+        perm_index++;
+    }
+
+    return std::make_shared< forms::and_t >( all_orderings_uncolorable );
+
+}
+
+cbx::hypergraph_t read_hypergraph( int n
+                            , sat_solver_t &solver
+                            , bimap< var_t, int > translation )
+{
+    cbx::hypergraph_t h( n );
+    for ( int index = 0; index < h.slots(); index++ )
+        if ( solver.val( translation.left.at( edge_present( index ) ) ) > 0 )
+            h.add_edge( index );
+    return h;
+}
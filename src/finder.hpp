@@ -0,0 +1,356 @@
+#pragma once
+
+// The encoding of the search: the blue coloring formula, the red
+// uncolorability formula and the hypergraph the lattice traversal works on.
+
+#include <Discreture/Combinations.hpp>
+#include <Discreture/Permutations.hpp>
+#include <discreture.hpp>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "kck_cnf.hpp"
+#include "kck_form.hpp" 
+#include "kck_prof.hpp"
+#include "kck_report.hpp"
+#include "kck_sat.hpp"
+#include "kck_share.hpp"
+
+#include "cbx_3unihg.hpp"
+#include "cbx_sim.hpp"
+
+using pattern = std::array< int, 3 >;
+using palette_t = std::vector< pattern >;
+using var_t = std::pair< char, std::vector< int > >;
+
+namespace kck {
+
+std::ostream& operator<<( std::ostream& os, const std::vector< int > &v );
+std::ostream& operator<<( std::ostream& os, const std::set< int > &s );
+
+template < typename L, typename R >
+std::ostream& operator<<( std::ostream& os, const std::pair< L, R > &var )
+{
+    return os << "(" << var.first << ", " << var.second << ")";
+}
+
+}
+
+using lit_t = kck::literal< var_t >;
+using forms = kck::forms_t< lit_t >;
+
+//// Variables ////////////////////////////////////////////////////////////////
+
+lit_t labeler( int i );
+
+kck::formula_ptr< lit_t > llit( var_t v, bool pos );
+
+var_t arc_color( int i, int j, int color );
+
+var_t edge_present( int edge_index );
+
+var_t role_label( int p, int i, int j, int role );
+
+//// Coloring formula /////////////////////////////////////////////////////////
+
+kck::cnf_t< lit_t > cnf_triangle( const palette_t &palette
+                                , int i, int j, int k, int edge_index
+                                , kck::cnf_builder< lit_t > &builder );
+
+kck::cnf_t< lit_t > cnf_triangles( const palette_t &palette
+                                 , int n
+                                 , kck::cnf_builder< lit_t > &builder );
+
+kck::cnf_t< lit_t > cnf_coloring( int n, int colors );
+
+// Formulas which end up in one solver have to share the builder, otherwise
+// their Tseitin variables collide.
+kck::cnf_t< lit_t > build_coloring_cnf( 
+    int n, 
+    int colors, 
+    const palette_t &palette, 
+    kck::cnf_builder< lit_t > &builder );
+
+kck::cnf_t< lit_t > build_coloring_cnf( int n, int colors, const palette_t &palette );
+
+// The clauses build_coloring_cnf adds for the vertex v on top of those for
+// v vertices: the arcs into v and the triangles with v as their largest
+// vertex.
+kck::cnf_t< lit_t > build_coloring_cnf_vertex( int v
+                                             , int colors
+                                             , const palette_t &palette
+                                             , kck::cnf_builder< lit_t > &builder );
+
+//// Blue coloring ////////////////////////////////////////////////////////////
+
+extern palette_t blue_palette;
+
+constexpr int blue_colors = 7;
+
+//// Graph representation /////////////////////////////////////////////////////
+
+struct lat_order_t;
+
+struct lat_hypergraph_t
+{
+    int n;
+
+    cbx::hypergraph_t graph;
+
+    long counter_graph_entered = 0;
+    long counter_blue_colorable = 0;
+
+    // The graphs passed to the collect function.
+    std::vector< cbx::hypergraph_t > solutions;
+
+    kck::bimap< var_t, int > translation;
+
+    // Solver variables of edge_present, by edge index.
+    std::vector< int > edge_vars;
+
+    // The blue base formula only depends on n, its hash keys the lemmas
+    // learned about it.
+    std::uint64_t blue_hash = 0;
+
+    // Collects learned clauses of blue_solver once warm_start is called.
+    std::unique_ptr< kck::clause_collector > lemmas;
+
+    kck::sat_solver_t blue_solver;
+
+    // Branching order of the traversal, the edges in index order if null.
+    std::shared_ptr< const lat_order_t > order;
+
+    // The edges branched on above the current node, by level and as a set.
+    std::vector< int > branched;
+    cbx::edge_bits_t decided;
+
+    // Solver variables of arc_color( i, j, c ) for the colors c <
+    // palette_colors the blue palette uses, at adj_i( n, i, j ) *
+    // palette_colors + c and 0 where the formula has none, and the colors
+    // every arc has in the last blue model as a bit set. Kept only for
+    // orders which look at the model.
+    int palette_colors = 0;
+    std::vector< int > color_vars;
+    std::vector< unsigned > arc_colors;
+
+    // Solver statistics of the parallel workers, summed as they retire.
+    std::map< std::string, double > worker_stats;
+
+    // Builds and loads the blue formula, timing the formula build, int
+    // translation and add_cnf phases in report if given.
+    lat_hypergraph_t( int n, kck::run_report *report = nullptr )
+        : n( n )
+        , graph( n )
+    {
+        auto timed = [ & ]( const char *name, auto f )
+        {
+            return report ? report->timed( name, f ) : f();
+        };
+
+        auto blue_formula = timed( "formula build", [ & ]()
+        {
+            return build_coloring_cnf( n, blue_colors, blue_palette );
+        } );
+        auto [ translated, translation ] = timed( "int translation", [ & ]()
+        {
+            return kck::to_int_cnf( blue_formula );
+        } );
+        this->translation = translation;
+        for ( int i = 0; i < cbx::choose( n, 3 ); i++ )
+            edge_vars.push_back( translation.left.at( edge_present( i ) ) );
+        blue_hash = kck::cnf_hash( translated );
+        timed( "add_cnf", [ & ]() { kck::add_cnf( blue_solver, translated ); } );
+    }
+
+    // Worker for the parallel traversal, it gets its own graph and its
+    // own copy of the loaded blue solver.
+    lat_hypergraph_t( const lat_hypergraph_t &base )
+        : n( base.n )
+        , graph( base.n )
+        , translation( base.translation )
+        , edge_vars( base.edge_vars )
+        , order( base.order )
+        , palette_colors( base.palette_colors )
+        , color_vars( base.color_vars )
+    {
+        base.blue_solver.copy( blue_solver );
+        if ( base.lemmas )
+        {
+            lemmas = std::make_unique< kck::clause_collector >( base.lemmas->max_size
+                                                         , base.lemmas->capacity );
+            blue_solver.connect_learner( lemmas.get() );
+        }
+    }
+
+    // Adds lemmas stored by earlier runs to the blue solver and starts
+    // collecting the short clauses it learns.
+    void warm_start( const std::vector< std::vector< int > > &stored, int max_size )
+    {
+        lemmas = std::make_unique< kck::clause_collector >( max_size );
+        for ( auto &clause : stored )
+        {
+            kck::add_cnf( blue_solver, clause );
+            lemmas->insert( clause );
+        }
+        blue_solver.connect_learner( lemmas.get() );
+    }
+
+    lat_hypergraph_t& operator=( const lat_hypergraph_t& ) = delete;
+
+    // Adds the solver statistics of a worker which is done for good.
+    void retire( lat_hypergraph_t &worker )
+    {
+        for ( auto &[ key, value ] : kck::solver_statistics( worker.blue_solver ) )
+            worker_stats[ key ] += value;
+    }
+
+    void join( lat_hypergraph_t &worker )
+    {
+        counter_graph_entered += worker.counter_graph_entered;
+        counter_blue_colorable += worker.counter_blue_colorable;
+        worker.counter_graph_entered = 0;
+        worker.counter_blue_colorable = 0;
+        std::move( worker.solutions.begin(), worker.solutions.end()
+                 , std::back_inserter( solutions ) );
+        worker.solutions.clear();
+        if ( lemmas && worker.lemmas )
+            lemmas->merge( *worker.lemmas );
+    }
+
+    void add_edge( int index )
+    {
+        graph.add_edge( index );
+    }
+
+    void remove_edge( int index )
+    {
+        graph.remove_edge( index );
+    }
+
+    int solve_blue()
+    {
+        KCK_PROF_SCOPE( "solve_blue" );
+        for ( int i = 0; i < cbx::choose( n, 3 ); i++ )
+            blue_solver.assume( graph.has_edge( i ) ? edge_vars[ i ] : - edge_vars[ i ] );
+        int res = blue_solver.solve();
+        if ( res == SAT_Y && ! color_vars.empty() )
+            read_arc_colors();
+        return res;
+    }
+
+    void set_order( std::shared_ptr< const lat_order_t > order );
+
+    // The edge to branch on at the current node, which is on the given level.
+    int branch_edge( int level );
+
+    private:
+    void read_arc_colors();
+
+};
+
+std::ostream& operator<<( std::ostream& os, const lat_hypergraph_t& h );
+
+//// Branching orders /////////////////////////////////////////////////////////
+
+// Chooses the edge the lattice traversal decides next, see trav_3hg_lat_go.
+// Edges decided above the node are in h.decided, they are h.branched[ 0 ],
+// ..., h.branched[ level - 1 ].
+struct lat_order_t
+{
+    virtual ~lat_order_t() = default;
+
+    virtual int pick( const lat_hypergraph_t &h, int level ) const = 0;
+
+    // Orders looking at the last blue model depend on the history of the
+    // solver, not only on the node, and only run sequentially.
+    virtual bool uses_model() const { return false; }
+};
+
+// The orders by name:
+//
+//   index    the edges in index order
+//   degree   the edge whose vertices have the largest degree sum in the
+//            current graph
+//   palette  the most constrained triangle, the one with the fewest palette
+//            patterns compatible with the arc colors the last blue model
+//            commits the current edges to
+//   lemmas   a static order, the edges by how many lemmas learned about
+//            the blue formula mention them, see lat_hypergraph_t::warm_start;
+//            needs the lemmas loaded
+//
+// Orders reading the state of h are made once it is set up.
+std::shared_ptr< const lat_order_t > make_lat_order( const std::string &name
+                                                   , const lat_hypergraph_t &h );
+
+//// Red coloring /////////////////////////////////////////////////////////////
+
+// The red checks are compiled for every n from min_fixed_n to max_fixed_n,
+// with the edge loop and the role table of constant size. Other n take the
+// generic loop.
+constexpr int min_fixed_n = 4;
+constexpr int max_fixed_n = 10;
+
+bool is_perm_colorable( const lat_hypergraph_t &h, const std::vector< int > &perm );
+
+// Whether some permutation of the vertices colors h, the first one found is
+// stored in perm if given.
+bool find_perm_coloring( const lat_hypergraph_t &h, std::vector< int > *perm = nullptr );
+
+bool is_r_uncolorable( lat_hypergraph_t &h );
+
+forms::form_p red_uncolor_formula( int n );
+
+//// Lattice callbacks ////////////////////////////////////////////////////////
+
+using coloring_t = std::map< std::pair< int, int >, int >;
+
+coloring_t get_coloring_solution( const lat_hypergraph_t &h
+                                , int colors
+                                , kck::sat_solver_t &solver );
+
+// Records the graph as a solution and prints it with its blue coloring.
+void print_graph( lat_hypergraph_t &h );
+
+bool is_b_uncolorable( lat_hypergraph_t &h );
+
+//// Witness minimization ///////////////////////////////////////////////////
+
+// is_r_uncolorable which remembers the permutations it found to color a
+// graph and tries them first. A permutation coloring a graph colors all of
+// its subgraphs, so during a minimization most colorable queries are
+// answered from the cache.
+struct red_check_t
+{
+    std::vector< std::vector< int > > cache;
+    long checks = 0;
+    long cache_hits = 0;
+
+    bool is_r_uncolorable( lat_hypergraph_t &h );
+};
+
+struct minimize_stats_t
+{
+    long red_checks = 0;
+    long cache_hits = 0;
+    double seconds = 0;
+};
+
+// An inclusion-minimal subset of the edges of h which is still red
+// uncolorable, found by QuickXplain. Blue colorability carries over to
+// subgraphs and is checked once on the result with the blue solver. h has
+// to be red uncolorable and ends up with the minimal edge set.
+const cbx::hypergraph_t& minimize_witness( lat_hypergraph_t &h
+                                         , minimize_stats_t *stats = nullptr );
+
+cbx::hypergraph_t minimize_witness( const cbx::hypergraph_t &h
+                                  , minimize_stats_t *stats = nullptr );
+
+//// Models ///////////////////////////////////////////////////////////////////
+
+cbx::hypergraph_t read_hypergraph( int n
+                                 , kck::sat_solver_t &solver
+                                 , kck::bimap< var_t, int > translation );
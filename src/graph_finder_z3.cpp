@@ -1,6 +1,12 @@
 #include <Discreture/Combinations.hpp>
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <optional>
 #include <string>
+#include <thread>
 #include <vector>
 #include <map>
 
@@ -10,6 +16,9 @@
 
 #include "cbx_3unihg.hpp"
 #include "kck_log.hpp"
+#include "kck_pool.hpp"
+#include "kck_qbf.hpp"
+#include "kck_report.hpp"
 
 #include "cbx_turan.hpp"
 #include "cbx_utils.hpp"
@@ -31,11 +40,9 @@ struct graph
 
     z3::expr_vector edges;
 
-    std::map< std::tuple< int, int, int >, int > edge_indices;
-
     z3::expr edge( int i, int j, int k )
     {
-        assert( i < j && j < k ); return edges[ edge_indices.at( { i, j, k } ) ];
+        assert( i < j && j < k ); return edges[ cbx::rank_3( i, j, k ) ];
     }
 
     z3::expr edge( const std::vector< int >& e )
@@ -49,21 +56,16 @@ struct graph
         , name( name )
         , edges( c )
     {
-        int counter = 0;
-        for ( auto &x : discreture::combinations( n, 3 ) ) {
-            edge_indices.insert( { { x[ 0 ], x[ 1 ], x[ 2 ] }
-                                 , counter } );
+        for ( auto &x : discreture::combinations( n, 3 ) )
             edges.push_back( c.bool_const( edge_var( name, x[ 0 ], x[ 1 ], x[ 2 ] ).c_str() ) );
-            counter++;
-        }
     }
 
     cbx::hypergraph_t read( z3::model m )
     {
         cbx::hypergraph_t res( n );
-        for ( auto &x : discreture::combinations( n, 3 ) )
-            if ( m.eval( edge( x[ 0 ], x[ 1 ], x[ 2 ] ) ).is_true() )
-                res.edges.insert( { x[ 0 ], x[ 1 ], x[ 2 ] } );
+        for ( int e = 0; e < res.slots(); e++ )
+            if ( m.eval( edges[ e ] ).is_true() )
+                res.add_edge( e );
         return res;
     }
 
@@ -192,15 +194,17 @@ struct coloring
         }
     }
 
+    // The arc between i and j, given in either order.
     std::string color_var( int i, int j )
     {
+        if ( i > j ) std::swap( i, j );
         return name_ + "_c_" + std::to_string( i ) + "," + std::to_string( j );
     }
 
     z3::expr color( int i, int j )
     {
-        assert( i < j );
-        return colors[ color_indices.at( { i, j } ) ];
+        assert( i != j );
+        return colors[ color_indices.at( { std::min( i, j ), std::max( i, j ) } ) ];
     }
 
     z3::expr respects_palette( z3::context &c
@@ -246,6 +250,21 @@ struct coloring
 
     }
 
+    // The arcs ij, jk and ik follow one of the patterns, i, j, k need not
+    // be sorted.
+    z3::expr triangle_respects( z3::context &c
+                              , int i, int j, int k
+                              , cbx::palette_t &palette )
+    {
+        z3::expr_vector triangle_coloring( c );
+        for ( auto &p : palette )
+            triangle_coloring.push_back( 
+                ( color( i, j ) == color_sort.val( c, p[ 0 ] )
+               && color( j, k ) == color_sort.val( c, p[ 1 ] )
+               && color( i, k ) == color_sort.val( c, p[ 2 ] ) ).simplify() );
+        return z3::mk_or( triangle_coloring );
+    }
+
     std::map< std::pair< int, int >, int > read( const z3::model &m )
     {
         std::map< std::pair< int, int >, int > res;
@@ -313,21 +332,28 @@ struct permutation
                 links.push_back( c.bool_const( link_var( i, j ).c_str() ) );
     }
 
+    // v is mapped into the set b.
+    z3::expr maps_into( z3::context &c, int v, const std::vector< int > &b )
+    {
+        z3::expr_vector targets( c );
+        for ( int w : b )
+            targets.push_back( link( v, w ) );
+        return z3::mk_or( targets );
+    }
+
+    // The image of the set a is b. As the links form a permutation, it is
+    // enough that every element of a is mapped into b, which takes |a| * |b|
+    // links instead of enumerating the |a|! bijections.
     z3::expr maps_to( z3::context &c
                     , const std::vector< int > &a
                     , const std::vector< int > &b )
     {
         assert( a.size() == b.size() );
 
-        z3::expr_vector any_perm( c );
-        for ( auto &&p : discreture::permutations( ( int ) a.size() ) )
-        {
-            z3::expr_vector one_perm( c );
-            for ( int i = 0; i < a.size(); i++ )
-                one_perm.push_back( link( a[ i ], b[ p[ i ] ] ) );
-            any_perm.push_back( z3::mk_and( one_perm ) );
-        }
-        return z3::mk_or( any_perm );
+        z3::expr_vector all_into( c );
+        for ( int v : a )
+            all_into.push_back( maps_into( c, v, b ) );
+        return z3::mk_and( all_into );
     }
 
     z3::expr formula( z3::context &c )
@@ -372,41 +398,112 @@ z3::expr mk_eq( z3::context &c, z3::expr a, z3::expr b )
     return z3::to_expr( c, Z3_mk_eq( c, a, b ) );
 }
 
-struct graph_iso
+// A linear order of the vertices, which stands in for a permutation phi
+// with phi( u ) the position of u. lt_{u,v} for u < v says that u comes
+// before v; transitivity on every triple takes two clauses, as a tournament
+// without cyclic triangles is a linear order.
+struct linear_order
 {
     int n;
-    permutation p;
-    std::string name;
+    std::string name_;
+    z3::expr_vector lts;
 
-    graph_iso( z3::context &c, int n, std::string name )
-        : n( n ), name( name ), p( c, n, name + "_p" )
-    {}
+    linear_order( z3::context &c, int n, std::string name )
+        : n( n ), name_( std::move( name ) ), lts( c )
+    {
+        for ( auto &a : discreture::combinations( n, 2 ) )
+            lts.push_back( c.bool_const( lt_var( a[ 0 ], a[ 1 ] ).c_str() ) );
+    }
 
-    z3::expr iso( z3::context &c
-                , graph &g 
-                , graph &h )
+    // The variable of the pair u < v, ordered by the larger vertex as in
+    // discreture::combinations( n, 2 ).
+    int pair_index( int u, int v ) const
     {
-        assert( g.n == h.n );
-        z3::expr_vector form( c );
+        assert( u < v );
+        return cbx::choose( v, 2 ) + u;
+    }
 
-        for ( auto &x : discreture::combinations( g.n, 3 ) )
+    std::string lt_var( int u, int v ) const
+    {
+        return name_ + "-lt_" + std::to_string( u ) + "," + std::to_string( v );
+    }
+
+    // u comes before v.
+    z3::expr less( int u, int v )
+    {
+        return u < v ? lts[ pair_index( u, v ) ] : ! lts[ pair_index( v, u ) ];
+    }
+
+    z3::expr formula( z3::context &c )
+    {
+        z3::expr_vector form( c );
+        for ( auto &t : discreture::combinations( n, 3 ) )
         {
-            for ( auto &y : discreture::combinations( g.n, 3 ) )
-            {
-                auto atom = z3::implies( p.maps_to( c, x, y )
-                                       , ( g.edge( x ) == h.edge( y ) ) );
-                form.push_back( atom );
-            }
+            int a = t[ 0 ], b = t[ 1 ], d = t[ 2 ];
+            form.push_back( z3::implies( less( a, b ) && less( b, d ), less( a, d ) ) );
+            form.push_back( z3::implies( less( d, b ) && less( b, a ), less( d, a ) ) );
         }
-        return p.formula( c ) && z3::mk_and( form );
+        return z3::mk_and( form );
+    }
+
+    // The position of every vertex.
+    std::vector< int > read( const z3::model &m )
+    {
+        std::vector< int > res( n, 0 );
+        for ( int u = 0; u < n; u++ )
+            for ( int v = 0; v < n; v++ )
+                if ( u != v && m.eval( less( v, u ) ).is_true() )
+                    res[ u ]++;
+        return res;
     }
 
     z3::expr_vector &vars()
     {
-        return p.vars();
+        return lts;
     }
 };
 
+// Calls f with the 3! orders of the triple x.
+template < typename fun_t >
+void for_orientations( const std::vector< int > &x, fun_t f )
+{
+    std::array< int, 3 > s{ x[ 0 ], x[ 1 ], x[ 2 ] };
+    std::sort( s.begin(), s.end() );
+    do
+        f( s[ 0 ], s[ 1 ], s[ 2 ] );
+    while ( std::next_permutation( s.begin(), s.end() ) );
+}
+
+// The red coloring respects the palette on the image h of g under phi,
+// without the edges of h. col is the red coloring pulled back to g, col( u,
+// v ) = red( phi( u ), phi( v ) ), which ranges over all colorings as red
+// does. The image of the edge x lists its vertices in the order phi puts on
+// x, so for each of the six orders s of x:
+//
+//   g_x and s_0 < s_1 < s_2  ->  ( col( s_0 s_1 ), col( s_1 s_2 ), col( s_0 s_2 ) )
+//                                is a pattern
+//
+// which is O( n^3 |palette| ) instead of a term per pair of triples.
+template < typename color_sort_t >
+z3::expr respects_palette_image( z3::context &c
+                               , coloring< color_sort_t > &col
+                               , graph &g
+                               , linear_order &phi
+                               , cbx::palette_t &palette )
+{
+    z3::expr_vector form( c );
+    for ( auto &x : discreture::combinations( g.n, 3 ) )
+    {
+        z3::expr edge = g.edge( x[ 0 ], x[ 1 ], x[ 2 ] );
+        for_orientations( { x[ 0 ], x[ 1 ], x[ 2 ] }, [ & ]( int a, int b, int d )
+        {
+            form.push_back( z3::implies( edge && phi.less( a, b ) && phi.less( b, d )
+                                       , col.triangle_respects( c, a, b, d, palette ) ) );
+        } );
+    }
+    return z3::mk_and( form );
+}
+
 void test_perm()
 {
     z3::context c;
@@ -463,33 +560,48 @@ void test_graph()
 
     auto model_g = g.read( model );
 
-    assert( model_g.edges.find( { 0, 1, 2 } ) == model_g.edges.end() );
-
-    bool has_edge = false;
-    for ( auto &x : discreture::combinations( g.n, 3 ) )
-        has_edge |= model_g.edges.find( { x[ 0 ], x[ 1 ], x[ 2 ] } ) != model_g.edges.end();
-    assert( has_edge );
+    assert( ! model_g.has_edge( 0, 1, 2 ) );
+    assert( model_g.edge_count() > 0 );
 }
 
-void test_iso()
+void test_order()
 {
     z3::context c;
     z3::solver s( c );
 
-    int n = 4;
+    linear_order phi( c, 4, "phi" );
+    s.add( phi.formula( c ) );
+    s.add( phi.less( 3, 1 ) && phi.less( 1, 2 ) && phi.less( 2, 0 ) );
+
+    assert( s.check() );
+    std::vector< int > pos = phi.read( s.get_model() );
+    assert( ( pos == std::vector< int >{ 3, 1, 2, 0 } ) );
+
+    s.add( phi.less( 0, 3 ) );
+    assert( ! s.check() );
+}
 
-    graph g( c, n, "g" );
-    graph h( c, n, "h" );
+void test_palette_image()
+{
+    z3::context c;
+    z3::solver s( c );
 
-    auto f = graph_iso( c, n, "phi" );
+    graph g( c, 4, "g" );
+    linear_order phi( c, 4, "phi" );
+    coloring< int_sort > col( c, 4, 2, "col" );
+    cbx::palette_t palette = { { 0, 0, 1 } };
 
-    s.add( f.iso( c, g, h ) );
+    s.add( phi.formula( c ) );
+    s.add( respects_palette_image( c, col, g, phi, palette ) );
     s.add( g.edge( 0, 1, 2 ) );
-    s.add( f.p.maps_to( c, { 0, 1, 2 }, { 1, 2, 3 } ) );
-    s.add( ! h.edge( 1, 2, 3 ) );
+    s.add( phi.less( 2, 1 ) && phi.less( 1, 0 ) );
 
-    auto res = s.check();
-    assert( ! res );
+    // The image of { 0, 1, 2 } is ordered 2, 1, 0.
+    assert( s.check() );
+    auto m = s.get_model();
+    assert( m.eval( col.color( 2, 1 ) ).get_numeral_int() == 0 );
+    assert( m.eval( col.color( 1, 0 ) ).get_numeral_int() == 0 );
+    assert( m.eval( col.color( 2, 0 ) ).get_numeral_int() == 1 );
 }
 
 void test_coloring_5()
@@ -536,81 +648,431 @@ void tests()
     test_perm();
     test_perm_2();
     test_graph();
-    test_iso();
+    test_order();
+    test_palette_image();
     test_coloring_5();
     test_coloring_6();
 }
 
 
-int main( int arc, char** argv )
+//// Propositional encoding /////////////////////////////////////////////////
+
+// The same problem as kck formulas over the names of the z3 constants, a
+// color of an arc becomes one boolean per value. Models of the exists block
+// are handed back as z3 models, so graph::read works on both pipelines.
+
+using zlit_t = kck::literal< std::string >;
+using zforms = kck::forms_t< zlit_t >;
+
+zlit_t aux_labeler( int i ) { return { "aux_" + std::to_string( i ), true }; }
+
+zforms::form_p prop( const std::string &name, bool pos = true )
 {
+    return zforms::f_lit( { name, pos } );
+}
 
-    tests();
+zforms::form_p prop( const z3::expr &e, bool pos = true )
+{
+    return prop( e.decl().name().str(), pos );
+}
 
-    int n = std::stoi( argv[ 1 ] );
+zforms::form_p prop_exactly_one( const std::vector< std::string > &names )
+{
+    zforms::and_t res;
+    zforms::or_t some;
+    for ( auto &name : names )
+        some.push( prop( name ) );
+    res.push( some );
+    for ( std::size_t a = 0; a < names.size(); a++ )
+        for ( std::size_t b = a + 1; b < names.size(); b++ )
+            res.push( zforms::f_or( { prop( names[ a ], false ), prop( names[ b ], false ) } ) );
+    return std::make_shared< zforms::and_t >( res );
+}
 
-    cbx::palette_t blue_palette = { { 0, 1, 2 }
-                                  , { 3, 0, 4 }
-                                  , { 5, 6, 0 } };
+template < typename color_sort_t >
+std::string color_value( coloring< color_sort_t > &col, int i, int j, int c )
+{
+    return col.color_var( i, j ) + "=" + std::to_string( c );
+}
 
-    // | a a b |
-    // | b c c |
-    cbx::palette_t red_palette = { { 0, 0, 1 }
-                                 , { 0, 0, 2 }
-                                 , { 0, 2, 1 }
-                                 , { 0, 2, 2 }
-                                 , { 1, 0, 1 }
-                                 , { 1, 0, 2 }
-                                 , { 1, 2, 1 }
-                                 , { 1, 2, 2 } };
+// Every arc gets exactly one color.
+template < typename color_sort_t >
+zforms::form_p prop_arc_colors( coloring< color_sort_t > &col
+                              , std::vector< std::string > &vars )
+{
+    zforms::and_t res;
+    for ( auto &a : discreture::combinations( col.n, 2 ) )
+    {
+        std::vector< std::string > values;
+        for ( int c = 0; c < col.color_sort.n; c++ )
+            values.push_back( color_value( col, a[ 0 ], a[ 1 ], c ) );
+        vars.insert( vars.end(), values.begin(), values.end() );
+        res.push( prop_exactly_one( values ) );
+    }
+    return std::make_shared< zforms::and_t >( res );
+}
+
+template < typename color_sort_t >
+zforms::form_p prop_triangle( coloring< color_sort_t > &col
+                            , int i, int j, int k
+                            , const cbx::palette_t &palette )
+{
+    zforms::or_t triangle;
+    for ( auto &p : palette )
+        triangle.push( zforms::f_and( { prop( color_value( col, i, j, p[ 0 ] ) )
+                                      , prop( color_value( col, j, k, p[ 1 ] ) )
+                                      , prop( color_value( col, i, k, p[ 2 ] ) ) } ) );
+    return std::make_shared< zforms::or_t >( triangle );
+}
+
+// Every edge of g follows the palette.
+template < typename color_sort_t >
+zforms::form_p prop_respects_palette( coloring< color_sort_t > &col
+                                    , graph &g
+                                    , const cbx::palette_t &palette
+                                    , std::vector< std::string > &vars )
+{
+    zforms::and_t res;
+    res.push( prop_arc_colors( col, vars ) );
+    for ( auto &e : discreture::combinations( col.n, 3 ) )
+        res.push( zforms::f_or( { prop( g.edge( e[ 0 ], e[ 1 ], e[ 2 ] ), false )
+                                , prop_triangle( col, e[ 0 ], e[ 1 ], e[ 2 ], palette ) } ) );
+    return std::make_shared< zforms::and_t >( res );
+}
+
+// Propositional respects_palette_image, the order is a tournament on the
+// lt variables with the transitivity clauses of linear_order::formula.
+template < typename color_sort_t >
+zforms::form_p prop_respects_palette_image( coloring< color_sort_t > &col
+                                          , graph &g
+                                          , linear_order &phi
+                                          , const cbx::palette_t &palette
+                                          , std::vector< std::string > &vars )
+{
+    zforms::and_t res;
+
+    auto less = [ & ]( int u, int v, bool pos = true )
+    {
+        return u < v ? prop( phi.lt_var( u, v ), pos ) : prop( phi.lt_var( v, u ), ! pos );
+    };
+
+    for ( auto &a : discreture::combinations( phi.n, 2 ) )
+        vars.push_back( phi.lt_var( a[ 0 ], a[ 1 ] ) );
+    for ( auto &t : discreture::combinations( phi.n, 3 ) )
+    {
+        int a = t[ 0 ], b = t[ 1 ], d = t[ 2 ];
+        res.push( zforms::f_or( { less( a, b, false ), less( b, d, false ), less( a, d ) } ) );
+        res.push( zforms::f_or( { less( d, b, false ), less( b, a, false ), less( d, a ) } ) );
+    }
+
+    res.push( prop_arc_colors( col, vars ) );
+
+    for ( auto &x : discreture::combinations( g.n, 3 ) )
+        for_orientations( { x[ 0 ], x[ 1 ], x[ 2 ] }, [ & ]( int a, int b, int d )
+        {
+            res.push( zforms::f_or( { prop( g.edge( x[ 0 ], x[ 1 ], x[ 2 ] ), false )
+                                    , less( a, b, false )
+                                    , less( b, d, false )
+                                    , prop_triangle( col, a, b, d, palette ) } ) );
+        } );
+    return std::make_shared< zforms::and_t >( res );
+}
+
+//// Search ///////////////////////////////////////////////////////////////////
+
+struct finder_problem
+{
+    int n;
+    z3::context &c;
+    graph g;
+    coloring< enum_sort > blue_coloring;
+    // Pulled back to g through phi, see respects_palette_image.
+    coloring< enum_sort > red_coloring;
+    linear_order phi;
+    cbx::palette_t blue_palette;
+    cbx::palette_t red_palette;
+
+    finder_problem( z3::context &c, int n )
+        : n( n )
+        , c( c )
+        , g( c, n, "g" )
+        , blue_coloring( c, n, 7, "blue" )
+        , red_coloring( c, n, 3, "red" )
+        , phi( c, n, "phi" )
+        , blue_palette{ { 0, 1, 2 }
+                      , { 3, 0, 4 }
+                      , { 5, 6, 0 } }
+          // | a a b |
+          // | b c c |
+        , red_palette{ { 0, 0, 1 }
+                     , { 0, 0, 2 }
+                     , { 0, 2, 1 }
+                     , { 0, 2, 2 }
+                     , { 1, 0, 1 }
+                     , { 1, 0, 2 }
+                     , { 1, 2, 1 }
+                     , { 1, 2, 2 } }
+    {}
+};
+
+// The original pipeline: the nested quantifiers go to z3's qsat tactic.
+z3::solver qsat_solver( finder_problem &pr )
+{
+    z3::context &c = pr.c;
 
-    z3::context c;
     z3::solver s = ( z3::tactic( c, "simplify" )
                    & z3::tactic( c, "dt2bv" )
                    & z3::tactic( c, "bit-blast" )
                    & z3::tactic( c, "qsat" ) ).mk_solver();
 
-    graph g( c, n, "g" );
-    graph h( c, n, "h" );
-    coloring< enum_sort > blue_coloring( c, n, 7, "blue" );
-    coloring< enum_sort > red_coloring( c, n, 3, "red" );
-    graph_iso f( c, n, "phi" );
-
     // There exists a g-coloring such that it respects blue palette.
     auto blue_formula =
-            blue_coloring.respects_palette( c, g, blue_palette );
+            pr.blue_coloring.respects_palette( c, pr.g, pr.blue_palette );
     s.add( blue_formula );
 
-    // for all h, such that they are iso to f, there is no red coloring
-
-    // g and h have to be iso
+    // For all h isomorphic to g via phi, there is no red coloring of h,
+    // i.e. no red coloring respects the palette on the image of g.
+    z3::expr_vector universal( c );
+    for ( auto v : pr.phi.vars() )
+        universal.push_back( v );
+    for ( auto v : pr.red_coloring.vars() )
+        universal.push_back( v );
 
-    // For all h : hyper( n, 3 ) . h ~= g =>
     auto red_formula =
-        z3::forall(
-            h.vars()
-            , ( z3::forall( f.vars()
-                          , ! f.iso( c, g, h ) )
-             || z3::forall( red_coloring.vars()
-                          , ! red_coloring.respects_palette( c
-                                                           , h
-                                                           , red_palette ) ) )
-        );
+        z3::forall( universal
+                  , ! ( pr.phi.formula( c )
+                     && respects_palette_image( c, pr.red_coloring, pr.g, pr.phi
+                                              , pr.red_palette ) ) );
 
     kck::trace( "f_red", red_formula );
 
     s.add( red_formula );
+    return s;
+}
 
-    bool sat = s.check();
+void report_stats( kck::run_report &report, const std::string &section, const z3::stats &stats )
+{
+    for ( unsigned i = 0; i < stats.size(); i++ )
+        report.set( section
+                  , stats.key( i )
+                  , stats.is_uint( i ) ? stats.uint_value( i ) : stats.double_value( i ) );
+}
+
+bool find_qsat( finder_problem &pr, kck::run_report &report )
+{
+    z3::solver s = report.timed( "formula build", [ & ]() { return qsat_solver( pr ); } );
+
+    bool sat = report.timed( "solve", [ & ]() { return s.check(); } );
     kck::trace( "sat", sat );
 
     kck::trace( "stats", s.statistics() );
 
     if ( sat )
     {
+        auto read = report.phase( "model read" );
         auto model = s.get_model();
-        kck::trace( "g", g.read( model ) );
-        kck::trace( "h", h.read( model ) );
+        kck::trace( "g", pr.g.read( model ) );
+    }
+
+    report.set( "formula", "assertions", s.assertions().size() );
+    report_stats( report, "solver", s.statistics() );
+    return sat;
+}
+
+// Beyond this the cubes neither fit an int nor finish.
+constexpr int max_cube_depth = 20;
+
+// qsat split on the first depth edges of g, at most max_cube_depth of
+// them. Z3 contexts are not thread
+// safe, so every worker builds the problem in its own context and solves
+// its cubes there, one scope each. The first satisfiable cube interrupts
+// the others.
+bool find_qsat_cubes( int n, int depth, int threads, kck::run_report &report )
+{
+    depth = std::min( { depth, cbx::choose( n, 3 ), max_cube_depth } );
+    int cubes = 1 << depth;
+
+    kck::steal_pool< int > pool( std::min( threads, cubes ) );
+    for ( int cube = 0; cube < cubes; cube++ )
+        pool.push( cube );
+
+    std::vector< std::unique_ptr< z3::context > > contexts;
+    std::vector< std::unique_ptr< finder_problem > > problems;
+    std::vector< std::optional< z3::solver > > solvers( pool.size() );
+
+    auto build = report.phase( "formula build" );
+    for ( int w = 0; w < pool.size(); w++ )
+    {
+        contexts.push_back( std::make_unique< z3::context >() );
+        problems.push_back( std::make_unique< finder_problem >( *contexts.back(), n ) );
+    }
+    // Building happens on the worker threads as well.
+    std::vector< std::thread > builders;
+    for ( int w = 0; w < pool.size(); w++ )
+        builders.emplace_back( [ &, w ]() { solvers[ w ] = qsat_solver( *problems[ w ] ); } );
+    for ( auto &b : builders )
+        b.join();
+    build.stop();
+
+    std::mutex result_lock;
+    std::atomic< bool > found = false;
+    int done = 0, unknown = 0;
+
+    auto solve = report.phase( "solve" );
+    pool.run( [ & ]( int w, int cube )
+    {
+        if ( found )
+            return;
+
+        finder_problem &pr = *problems[ w ];
+        z3::solver &s = *solvers[ w ];
+
+        auto start = std::chrono::steady_clock::now();
+        s.push();
+        for ( int i = 0; i < depth; i++ )
+            s.add( ( cube >> i ) & 1 ? pr.g.edges[ i ] : ! pr.g.edges[ i ] );
+        z3::check_result res = s.check();
+        std::chrono::duration< double > took = std::chrono::steady_clock::now() - start;
+
+        std::lock_guard< std::mutex > guard( result_lock );
+        if ( res == z3::unknown )
+        {
+            // Interrupted cubes do not count.
+            if ( ! found )
+                unknown++;
+            s.pop();
+            return;
+        }
+
+        done++;
+        kck::trace( "cube", cube, res == z3::sat ? "sat" : "unsat"
+                  , took.count(), "s", done, "/", cubes );
+
+        std::string section = "cube " + std::to_string( cube );
+        report.set( section, "result", res == z3::sat );
+        report.set( section, "seconds", took.count() );
+        report_stats( report, section, s.statistics() );
+
+        if ( res == z3::sat && ! found )
+        {
+            found = true;
+            kck::trace( "g", pr.g.read( s.get_model() ) );
+            pool.halt();
+            for ( auto &c : contexts )
+                c->interrupt();
+        }
+        s.pop();
+    } );
+    solve.stop();
+
+    if ( ! found && unknown )
+        throw std::runtime_error( "qsat does not know " + std::to_string( unknown ) + " cubes" );
+
+    report.set( "solver", "cubes", cubes );
+    report.set( "solver", "cubes_done", done );
+    kck::trace( "sat", bool( found ) );
+    return found;
+}
+
+// exists g, blue . forall phi, red . blue( g ) and
+//                                    not ( phi is a linear order
+//                                          and red respects the image of g )
+// solved by kck::solve_qbf2.
+bool find_cegar( finder_problem &pr, kck::run_report &report )
+{
+    auto build = report.phase( "formula build" );
+
+    kck::qbf2_t< zlit_t > problem;
+    for ( unsigned i = 0; i < pr.g.edges.size(); i++ )
+        problem.exists.push_back( pr.g.edges[ i ].decl().name().str() );
+
+    problem.outer = prop_respects_palette( pr.blue_coloring, pr.g, pr.blue_palette
+                                         , problem.exists );
+    problem.matrix = zforms::f_not(
+            prop_respects_palette_image( pr.red_coloring, pr.g, pr.phi, pr.red_palette
+                                       , problem.forall ) );
+    build.stop();
+
+    kck::cnf_builder< zlit_t > builder( aux_labeler );
+    auto res = report.timed( "solve", [ & ]() { return kck::solve_qbf2( problem, builder ); } );
+    kck::trace( "sat", res.res == SAT_Y, "rounds", res.rounds );
+    report.set( "solver", "rounds", res.rounds );
+
+    if ( res.res == SAT_U )
+        throw std::runtime_error( "qbf solver does not know" );
+
+    if ( res.res == SAT_Y )
+    {
+        auto read = report.phase( "model read" );
+        z3::model model( pr.c );
+        for ( unsigned i = 0; i < pr.g.edges.size(); i++ )
+        {
+            z3::func_decl edge = pr.g.edges[ i ].decl();
+            z3::expr value = pr.c.bool_val( res.model.at( edge.name().str() ) );
+            model.add_const_interp( edge, value );
+        }
+        kck::trace( "g", pr.g.read( model ) );
     }
+    return res.res == SAT_Y;
+}
+
+//// Main /////////////////////////////////////////////////////////////////////
+
+// graph_finder_z3 n [report.json] [--qsat] [--cubes[=depth] [--threads=k]]
+int main( int arc, char** argv )
+{
+
+    tests();
+
+    std::vector< std::string > positional;
+    bool qsat = false;
+    int depth = 0;
+    int threads = std::thread::hardware_concurrency();
+    for ( int i = 1; i < arc; i++ )
+    {
+        std::string arg = argv[ i ];
+        auto value = [ & ]( int def )
+        {
+            auto eq = arg.find( '=' );
+            return eq == std::string::npos ? def : std::stoi( arg.substr( eq + 1 ) );
+        };
+        if ( arg == "--qsat" )
+            qsat = true;
+        else if ( arg.rfind( "--cubes", 0 ) == 0 )
+            depth = value( 8 );
+        else if ( arg.rfind( "--threads", 0 ) == 0 )
+            threads = value( threads );
+        else
+            positional.push_back( arg );
+    }
+    if ( positional.empty() || depth < 0 || depth > max_cube_depth )
+        throw std::runtime_error( "usage: graph_finder_z3 n [report.json] [--qsat]"
+                                  " [--cubes[=depth] [--threads=k]], depth at most "
+                                  + std::to_string( max_cube_depth ) );
+
+    int n = std::stoi( positional[ 0 ] );
+
+    kck::run_report report( "z3" );
+    report.params = { { "n", std::to_string( n ) }
+                    , { "engine", depth ? "qsat cubes" : qsat ? "qsat" : "cegar" } };
+
+    bool sat;
+    if ( depth )
+    {
+        report.params[ "cubes" ] = std::to_string( depth );
+        report.params[ "threads" ] = std::to_string( threads );
+        sat = find_qsat_cubes( n, depth, threads, report );
+    }
+    else
+    {
+        z3::context c;
+        finder_problem problem( c, n );
+        sat = qsat ? find_qsat( problem, report ) : find_cegar( problem, report );
+    }
+
+    if ( positional.size() < 2 )
+        return 0;
 
+    report.result = sat ? "sat" : "unsat";
+    report.write( positional[ 1 ] );
 }
@@ -7,4 +7,22 @@ std::ostream& operator <<( std::ostream& os, const cnf_stats &s )
     return os << "CnfStats ( clauses = " << s.clauses << ", max clause size = " << s.max_clause_size << ", variable count = " << s.var_count << " )";
 }
 
+std::uint64_t cnf_hash( const cnf_t< int > &cnf )
+{
+    // FNV-1a over the literals, clauses are terminated by 0 as in DIMACS.
+    std::uint64_t h = 0xcbf29ce484222325ull;
+    auto mix = [ & ]( int lit )
+    {
+        h ^= static_cast< std::uint32_t >( lit );
+        h *= 0x100000001b3ull;
+    };
+    for ( auto &clause : cnf )
+    {
+        for ( int lit : clause )
+            mix( lit );
+        mix( 0 );
+    }
+    return h;
+}
+
 }
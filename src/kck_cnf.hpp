@@ -2,12 +2,15 @@
 
 #include "kck_str.hpp"
 #include <boost/dynamic_bitset/dynamic_bitset.hpp>
+#include <cstdint>
 #include <variant>
 #include <memory>
 #include <vector>
 
 #include <boost/bimap.hpp>
 
+#include "kck_prof.hpp"
+
 namespace kck {
 
 //// literal //////////////////////////////////////////////////////////////////
@@ -128,6 +131,7 @@ struct to_int_cnf_state
 
     int get_int_var( const lit_t &lit )
     {
+        KCK_PROF_SCOPE( "get_int_var" );
         auto it = mapping.left.find( lit.var );
 
         int var = 0;
@@ -315,4 +319,9 @@ struct cnf_stats cnf_get_stats( const cnf_t< lit_t > &cnf )
 
 std::ostream& operator <<( std::ostream& os, const cnf_stats& stats );
 
+//// hash /////////////////////////////////////////////////////////////////////
+
+// Hash of the clauses in order, identifies a translated formula across runs.
+std::uint64_t cnf_hash( const cnf_t< int > &cnf );
+
 }
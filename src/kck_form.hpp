@@ -8,6 +8,7 @@
 
 #include "kck_str.hpp"
 #include "kck_cnf.hpp"
+#include "kck_prof.hpp"
 
 namespace kck {
 
@@ -103,6 +104,7 @@ struct node_not : formula< lit_t >
 
     lit_t to_cnf_go( cnf_builder< lit_t >& builder ) const override
     {
+        KCK_PROF_SCOPE( "to_cnf_go" );
         lit_t node_lit = builder.get_help_lit();
         lit_t child_lit = child->to_cnf_go( builder );
         builder.push( { -node_lit, -child_lit } );
@@ -172,6 +174,7 @@ struct node_and : public nnary_node< lit_t >
 
     lit_t to_cnf_go( cnf_builder< lit_t > &builder ) const override 
     {
+        KCK_PROF_SCOPE( "to_cnf_go" );
         lit_t node_lit = builder.get_help_lit();
         auto children_ids = this->export_children( builder );
         for ( auto &i : children_ids ) {
@@ -205,6 +208,7 @@ struct node_or : public nnary_node< lit_t >
 
     lit_t to_cnf_go( cnf_builder< lit_t >& builder ) const override 
     {
+        KCK_PROF_SCOPE( "to_cnf_go" );
         lit_t node_lit = builder.get_help_lit();
         auto children_ids = this->export_children( builder );
         for ( auto &i : children_ids )
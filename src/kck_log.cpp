@@ -1,10 +1,161 @@
 #include "kck_log.hpp"
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
 namespace kck {
 
-void trace_go()
+namespace {
+
+//// Queue ////////////////////////////////////////////////////////////////////
+
+// Vyukov's intrusive MPSC queue: producers swap themselves in as the head
+// with one exchange, the writer follows the next pointers from the tail.
+struct record_t
+{
+    std::atomic< record_t* > next = nullptr;
+    std::string line;
+};
+
+struct log_queue
+{
+    record_t *tail;
+    std::atomic< record_t* > head;
+
+    log_queue() : tail( new record_t ), head( tail ) {}
+
+    ~log_queue()
+    {
+        std::string line;
+        while ( pop( line ) );
+        delete tail;
+    }
+
+    void push( record_t *r )
+    {
+        record_t *prev = head.exchange( r, std::memory_order_acq_rel );
+        prev->next.store( r, std::memory_order_release );
+    }
+
+    // Only called by the writer.
+    bool pop( std::string &line )
+    {
+        record_t *next = tail->next.load( std::memory_order_acquire );
+        if ( ! next )
+            return false;
+        line = std::move( next->line );
+        delete tail;
+        tail = next;
+        return true;
+    }
+};
+
+//// Writer ///////////////////////////////////////////////////////////////////
+
+struct log_writer
+{
+    log_queue queue;
+    std::atomic< std::uint64_t > queued = 0;
+    std::atomic< std::uint64_t > written = 0;
+
+    std::mutex lock;
+    std::condition_variable wake;
+    std::atomic< bool > sleeping = false;
+    std::atomic< bool > stopping = false;
+    std::thread thread;
+
+    log_writer() : thread( [ this ]() { run(); } ) {}
+
+    ~log_writer()
+    {
+        stopping = true;
+        wake.notify_one();
+        thread.join();
+    }
+
+    void push( std::string line )
+    {
+        auto *r = new record_t;
+        r->line = std::move( line );
+        queue.push( r );
+        queued.fetch_add( 1, std::memory_order_release );
+        if ( sleeping.load( std::memory_order_acquire ) )
+            wake.notify_one();
+    }
+
+    void run()
+    {
+        std::string line;
+        for ( ;; )
+        {
+            std::uint64_t n = 0;
+            while ( queue.pop( line ) )
+            {
+                std::cout << line;
+                n++;
+            }
+            if ( n > 0 )
+            {
+                std::cout.flush();
+                written.fetch_add( n, std::memory_order_release );
+                continue;
+            }
+
+            if ( stopping && written.load() == queued.load() )
+                return;
+
+            // A wake-up may slip between the check and the wait, so the
+            // wait is bounded rather than relying on every notify.
+            std::unique_lock< std::mutex > guard( lock );
+            sleeping = true;
+            wake.wait_for( guard, std::chrono::milliseconds( 10 ) );
+            sleeping = false;
+        }
+    }
+
+    void flush()
+    {
+        std::uint64_t target = queued.load( std::memory_order_acquire );
+        while ( written.load( std::memory_order_acquire ) < target )
+        {
+            wake.notify_one();
+            std::this_thread::yield();
+        }
+    }
+};
+
+std::atomic< bool > writer_gone = false;
+
+struct writer_handle
+{
+    log_writer writer;
+    ~writer_handle() { writer_gone = true; }
+};
+
+log_writer *writer()
+{
+    static writer_handle handle;
+    return writer_gone ? nullptr : &handle.writer;
+}
+
+}
+
+void log_write( std::string line )
+{
+    if ( log_writer *w = writer() )
+        w->push( std::move( line ) );
+    else
+        std::cout << line << std::flush;
+}
+
+void log_flush()
 {
-    std::cout << std::endl;
+    if ( log_writer *w = writer() )
+        w->flush();
 }
 
 }
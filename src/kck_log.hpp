@@ -1,10 +1,12 @@
 #pragma once
 
 #include <iostream>
+#include <sstream>
+#include <string>
 
 #ifdef TRACING
 
-#define TRACE(...) trace(...)
+#define TRACE(...) kck::trace( __VA_ARGS__ )
 
 #else
 
@@ -12,24 +14,70 @@
 
 #endif
 
+// Records below this level are compiled out: 0 debug, 1 info, 2 warning.
+#ifndef KCK_LOG_LEVEL
+#define KCK_LOG_LEVEL 1
+#endif
 
 namespace kck 
 {
 
-void trace_go();
+//// Sink /////////////////////////////////////////////////////////////////////
 
-template < typename T, typename ...Ts >
-void trace_go( const T& t, Ts... ts )
+// Records are formatted by the calling thread and handed through a
+// lock-free queue to a writer thread, which owns std::cout. Safe to call
+// from any thread; the order of records of one thread is kept.
+
+// Queues one line, which has to end with a newline.
+void log_write( std::string line );
+
+// Blocks until everything queued so far is written and flushed.
+void log_flush();
+
+//// Records //////////////////////////////////////////////////////////////////
+
+enum log_level_t { log_debug = 0, log_info = 1, log_warning = 2 };
+
+// A structured field, printed as key=value.
+template < typename T >
+struct field_t
+{
+    const char *key;
+    const T &value;
+};
+
+template < typename T >
+field_t< T > field( const char *key, const T &value ) { return { key, value }; }
+
+template < typename T >
+std::ostream& operator<<( std::ostream& os, const field_t< T > &f )
+{
+    return os << f.key << "=" << f.value;
+}
+
+template < typename ...Ts >
+void trace_go( std::ostream &os, const Ts&... ts )
+{
+    ( ( os << " " << ts ), ... );
+}
+
+template < int level, typename ...Ts >
+void log( const char* message, const Ts&... ts )
 {
-    std::cout << " " << t;
-    trace_go( ts... );
+    if constexpr ( level >= KCK_LOG_LEVEL )
+    {
+        std::ostringstream os;
+        os << "[" << message << "]";
+        trace_go( os, ts... );
+        os << "\n";
+        log_write( std::move( os ).str() );
+    }
 }
 
 template < typename T, typename ...Ts >
-void trace( const char* message, const T& t, Ts... ts )
+void trace( const char* message, const T& t, const Ts&... ts )
 {
-    std::cout << "[" << message << "]";
-    trace_go( t, ts... );
+    log< log_info >( message, t, ts... );
 }
 
 template < typename T >
@@ -38,5 +86,16 @@ void trace( const T& t )
     trace( "trc", t );
 }
 
+template < typename ...Ts >
+void debug( const char* message, const Ts&... ts )
+{
+    log< log_debug >( message, ts... );
+}
+
+template < typename ...Ts >
+void warn( const char* message, const Ts&... ts )
+{
+    log< log_warning >( message, ts... );
 }
 
+}
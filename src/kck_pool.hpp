@@ -0,0 +1,192 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace kck {
+
+//// Work-stealing pool ///////////////////////////////////////////////////////
+
+// Every worker owns a deque, takes work from its back and, once it runs dry,
+// steals from the front of the other deques. Tasks are pushed before run(),
+// so a worker quits as soon as a full sweep over the deques finds nothing.
+//
+// The pool remembers which task every worker is on until the worker reports
+// it finished, so frontier() always sees every task that is not done yet.
+template < typename task_t >
+struct steal_pool
+{
+    struct queue_t
+    {
+        std::mutex lock;
+        std::deque< task_t > tasks;
+    };
+
+    std::vector< std::unique_ptr< queue_t > > queues;
+    int next = 0;
+
+    // Guards active and is held while finished tasks are reported.
+    std::mutex frontier_lock;
+    std::vector< std::optional< task_t > > active;
+
+    std::atomic< bool > halted = false;
+
+    steal_pool( int workers )
+    {
+        for ( int i = 0; i < std::max( workers, 1 ); i++ )
+            queues.push_back( std::make_unique< queue_t >() );
+        active.resize( queues.size() );
+    }
+
+    int size() const { return queues.size(); }
+
+    // Tasks are dealt round robin, so that neighbouring subtrees start on
+    // different workers.
+    void push( task_t task )
+    {
+        queue_t &q = *queues[ next++ % size() ];
+        std::lock_guard< std::mutex > guard( q.lock );
+        q.tasks.push_back( std::move( task ) );
+    }
+
+    // Makes the workers quit after their current task.
+    void halt() { halted = true; }
+
+    bool pop( int worker, task_t &task )
+    {
+        for ( int i = 0; i < size(); i++ )
+        {
+            queue_t &q = *queues[ ( worker + i ) % size() ];
+            std::lock_guard< std::mutex > guard( q.lock );
+            if ( q.tasks.empty() )
+                continue;
+
+            if ( i == 0 )
+            {
+                task = std::move( q.tasks.back() );
+                q.tasks.pop_back();
+            }
+            else
+            {
+                task = std::move( q.tasks.front() );
+                q.tasks.pop_front();
+            }
+
+            std::lock_guard< std::mutex > active_guard( frontier_lock );
+            active[ worker ] = task;
+            return true;
+        }
+        return false;
+    }
+
+    // Calls fun with all tasks which are not finished, i.e. the queued ones
+    // and the ones being worked on. No task is finished while fun runs.
+    template < typename fun_t >
+    void frontier( fun_t fun )
+    {
+        std::vector< std::unique_lock< std::mutex > > guards;
+        for ( auto &q : queues )
+            guards.emplace_back( q->lock );
+        std::lock_guard< std::mutex > active_guard( frontier_lock );
+
+        std::vector< task_t > tasks;
+        for ( auto &a : active )
+            if ( a ) tasks.push_back( *a );
+        for ( auto &q : queues )
+            tasks.insert( tasks.end(), q->tasks.begin(), q->tasks.end() );
+        fun( tasks );
+    }
+
+    // Runs work( worker, task ) on one thread per deque until all tasks are
+    // done or the pool is halted. work returns whether the task was
+    // finished, in which case done( worker, task ) is called under the
+    // frontier lock. Unfinished tasks stay in the frontier. While waiting,
+    // the calling thread runs tick() every interval (never if it is zero).
+    //
+    // The first exception thrown by a worker stops the others and is
+    // rethrown here.
+    template < typename work_t, typename done_t, typename tick_t >
+    void run( work_t work
+            , done_t done
+            , tick_t tick
+            , std::chrono::milliseconds interval )
+    {
+        std::mutex state_lock;
+        std::condition_variable finished;
+        int running = size();
+        std::exception_ptr error;
+
+        std::vector< std::thread > threads;
+        for ( int w = 0; w < size(); w++ )
+            threads.emplace_back( [ &, w ]()
+            {
+                try
+                {
+                    task_t task;
+                    while ( ! halted && pop( w, task ) )
+                    {
+                        if ( ! work( w, task ) )
+                            continue;
+                        std::lock_guard< std::mutex > guard( frontier_lock );
+                        done( w, task );
+                        active[ w ].reset();
+                    }
+                }
+                catch ( ... )
+                {
+                    std::lock_guard< std::mutex > guard( state_lock );
+                    if ( ! error ) error = std::current_exception();
+                    halted = true;
+                }
+
+                std::lock_guard< std::mutex > guard( state_lock );
+                running--;
+                finished.notify_all();
+            } );
+
+        {
+            std::unique_lock< std::mutex > guard( state_lock );
+            while ( running > 0 )
+            {
+                if ( interval.count() == 0 )
+                {
+                    finished.wait( guard );
+                    continue;
+                }
+                if ( finished.wait_for( guard, interval ) == std::cv_status::timeout
+                  && running > 0 )
+                {
+                    guard.unlock();
+                    tick();
+                    guard.lock();
+                }
+            }
+        }
+
+        for ( auto &t : threads )
+            t.join();
+
+        if ( error )
+            std::rethrow_exception( error );
+    }
+
+    template < typename work_t >
+    void run( work_t work )
+    {
+        run( [ & ]( int w, task_t &task ) { work( w, task ); return true; }
+           , []( int, task_t& ) {}
+           , []() {}
+           , std::chrono::milliseconds( 0 ) );
+    }
+};
+
+}
@@ -0,0 +1,215 @@
+#include "kck_prof.hpp"
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace kck::prof {
+
+std::atomic< bool > active = false;
+
+namespace {
+
+// Never destroyed, so that scopes may still run while statics go away.
+struct registry
+{
+    std::mutex lock;
+    std::vector< std::unique_ptr< site > > sites;
+    std::vector< std::unique_ptr< thread_data > > threads;
+};
+
+registry &global()
+{
+    static registry *r = new registry;
+    return *r;
+}
+
+}
+
+const site *intern( const char *name )
+{
+    registry &r = global();
+    std::lock_guard< std::mutex > guard( r.lock );
+    for ( auto &s : r.sites )
+        if ( std::strcmp( s->name, name ) == 0 )
+            return s.get();
+    r.sites.push_back( std::make_unique< site >( site{ name } ) );
+    return r.sites.back().get();
+}
+
+node::~node()
+{
+    node *c = child.load();
+    while ( c )
+    {
+        node *next = c->sibling.load();
+        delete c;
+        c = next;
+    }
+}
+
+thread_data &local()
+{
+    // Owned by the registry, the data outlive their thread.
+    thread_local thread_data *t = nullptr;
+    if ( ! t )
+    {
+        registry &r = global();
+        std::lock_guard< std::mutex > guard( r.lock );
+        r.threads.push_back( std::make_unique< thread_data >() );
+        t = r.threads.back().get();
+    }
+    return *t;
+}
+
+node *child( node *parent, const site *s )
+{
+    node *first = parent->child.load( std::memory_order_acquire );
+    for ( node *c = first; c; c = c->sibling.load( std::memory_order_acquire ) )
+        if ( c->s == s )
+            return c;
+
+    node *c = new node( s, parent );
+    c->sibling.store( first, std::memory_order_relaxed );
+    parent->child.store( c, std::memory_order_release );
+    return c;
+}
+
+void record( node *n, std::uint64_t ns )
+{
+    bump( n->timed, 1 );
+    bump( n->total_ns, ns );
+    int b = 0;
+    while ( b + 1 < buckets && ( ns >> ( b + 1 ) ) )
+        b++;
+    bump( n->histogram[ b ], 1 );
+}
+
+void enable( bool on )
+{
+    active.store( on, std::memory_order_relaxed );
+}
+
+//// Dumps ////////////////////////////////////////////////////////////////////
+
+namespace {
+
+struct totals_t
+{
+    std::uint64_t calls = 0;
+    std::uint64_t timed = 0;
+    std::uint64_t total_ns = 0;
+    std::uint64_t self_ns = 0;
+    std::array< std::uint64_t, buckets > histogram{};
+};
+
+void collect( const node &n, const std::string &path, std::map< std::string, totals_t > &out )
+{
+    std::uint64_t children_ns = 0;
+    for ( node *c = n.child.load( std::memory_order_acquire ); c
+        ; c = c->sibling.load( std::memory_order_acquire ) )
+    {
+        std::string p = path.empty() ? c->s->name : path + ";" + c->s->name;
+        children_ns += c->total_ns.load( std::memory_order_relaxed );
+        collect( *c, p, out );
+    }
+
+    if ( ! n.s )
+        return;
+
+    totals_t &t = out[ path ];
+    t.calls += n.calls.load( std::memory_order_relaxed );
+    t.timed += n.timed.load( std::memory_order_relaxed );
+    std::uint64_t total = n.total_ns.load( std::memory_order_relaxed );
+    t.total_ns += total;
+    // Children are read after their parent, so they may be a bit ahead.
+    t.self_ns += total > children_ns ? total - children_ns : 0;
+    for ( int b = 0; b < buckets; b++ )
+        t.histogram[ b ] += n.histogram[ b ].load( std::memory_order_relaxed );
+}
+
+std::map< std::string, totals_t > collect_all()
+{
+    registry &r = global();
+    std::lock_guard< std::mutex > guard( r.lock );
+    std::map< std::string, totals_t > out;
+    for ( auto &t : r.threads )
+        collect( t->root, "", out );
+    return out;
+}
+
+// Upper bound of the bucket holding the q-th quantile.
+double quantile_us( const totals_t &t, double q )
+{
+    std::uint64_t seen = 0;
+    for ( int b = 0; b < buckets; b++ )
+    {
+        seen += t.histogram[ b ];
+        if ( seen > 0 && seen >= q * t.timed )
+            return std::ldexp( 1.0, b + 1 ) / 1000;
+    }
+    return 0;
+}
+
+}
+
+void dump_folded( std::ostream &os )
+{
+    for ( auto &[ path, t ] : collect_all() )
+        if ( t.timed > 0 )
+            os << path << " " << t.self_ns << "\n";
+}
+
+void dump_histograms( std::ostream &os )
+{
+    for ( auto &[ path, t ] : collect_all() )
+    {
+        os << path << " calls " << t.calls;
+        if ( t.timed > 0 )
+            os << " timed " << t.timed
+               << " total_ms " << t.total_ns / 1e6
+               << " mean_us " << t.total_ns / 1e3 / t.timed
+               << " p50_us " << quantile_us( t, 0.5 )
+               << " p90_us " << quantile_us( t, 0.9 )
+               << " p99_us " << quantile_us( t, 0.99 );
+        os << "\n";
+    }
+}
+
+#ifdef KCK_PROFILE
+
+namespace {
+
+// KCK_PROFILE=path switches the timers on and dumps them at exit.
+struct env_profile
+{
+    const char *path = std::getenv( "KCK_PROFILE" );
+
+    env_profile()
+    {
+        if ( path && *path )
+            enable();
+    }
+
+    ~env_profile()
+    {
+        if ( ! path || ! *path )
+            return;
+        std::ofstream folded( path );
+        dump_folded( folded );
+        std::ofstream hist( std::string( path ) + ".hist" );
+        dump_histograms( hist );
+    }
+} env_profile_instance;
+
+}
+
+#endif
+
+}
@@ -0,0 +1,160 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+
+// Scoped timers and counters for the hot paths.
+//
+//   KCK_PROF_SCOPE( "solve_blue" );     times the rest of the block
+//   KCK_PROF_COUNT( "imported", k );    adds k to a counter
+//
+// Both compile to nothing unless KCK_PROFILE is defined. When compiled in,
+// they are switched on at run time by kck::prof::enable() or by setting the
+// environment variable KCK_PROFILE=path, which writes folded stacks to path
+// and histograms to path.hist at exit.
+
+namespace kck::prof {
+
+//// Sites ////////////////////////////////////////////////////////////////////
+
+// A named instrumentation point. Sites are interned by name, so all
+// overrides of a virtual function may share one.
+struct site
+{
+    const char *name;
+};
+
+const site *intern( const char *name );
+
+//// Call tree ////////////////////////////////////////////////////////////////
+
+constexpr int buckets = 48;
+
+// A node of the per-thread call tree. Only the owning thread writes into
+// it, so the counters are plain loads and stores of atomics and readers
+// may dump them at any time.
+struct node
+{
+    const site *s;
+    node *parent;
+    std::atomic< node* > child = nullptr;
+    std::atomic< node* > sibling = nullptr;
+
+    std::atomic< std::uint64_t > calls = 0;
+    std::atomic< std::uint64_t > timed = 0;
+    std::atomic< std::uint64_t > total_ns = 0;
+    // Bucket b counts the durations in [ 2^b, 2^(b+1) ) ns.
+    std::array< std::atomic< std::uint64_t >, buckets > histogram{};
+
+    node( const site *s, node *parent ) : s( s ), parent( parent ) {}
+    ~node();
+};
+
+struct thread_data
+{
+    node root{ nullptr, nullptr };
+    node *current = &root;
+};
+
+thread_data &local();
+
+inline void bump( std::atomic< std::uint64_t > &a, std::uint64_t v )
+{
+    a.store( a.load( std::memory_order_relaxed ) + v, std::memory_order_relaxed );
+}
+
+node *child( node *parent, const site *s );
+
+void record( node *n, std::uint64_t ns );
+
+//// Control //////////////////////////////////////////////////////////////////
+
+extern std::atomic< bool > active;
+
+inline bool enabled() { return active.load( std::memory_order_relaxed ); }
+
+void enable( bool on = true );
+
+// Self time in ns per call stack, merged over threads, one "a;b;c ns" line
+// per stack as expected by flamegraph.pl.
+void dump_folded( std::ostream &os );
+
+// Calls, total time and percentiles per call stack.
+void dump_histograms( std::ostream &os );
+
+//// Scopes ///////////////////////////////////////////////////////////////////
+
+// Times its lifetime as a child of the enclosing scope. Direct recursion is
+// folded into the outermost call, which alone is timed.
+struct scope
+{
+    thread_data *t = nullptr;
+    node *outer;
+    std::chrono::steady_clock::time_point start;
+
+    scope( const site *s )
+    {
+        if ( ! enabled() )
+            return;
+
+        thread_data &td = local();
+        if ( td.current->s == s )
+        {
+            bump( td.current->calls, 1 );
+            return;
+        }
+
+        t = &td;
+        outer = td.current;
+        td.current = child( outer, s );
+        bump( td.current->calls, 1 );
+        start = std::chrono::steady_clock::now();
+    }
+
+    scope( const scope& ) = delete;
+
+    ~scope()
+    {
+        if ( ! t )
+            return;
+        auto ns = std::chrono::duration_cast< std::chrono::nanoseconds >(
+                std::chrono::steady_clock::now() - start ).count();
+        record( t->current, ns );
+        t->current = outer;
+    }
+};
+
+inline void count( const site *s, std::uint64_t k )
+{
+    if ( enabled() )
+        bump( child( local().current, s )->calls, k );
+}
+
+}
+
+#define KCK_PROF_CAT_( a, b ) a ## b
+#define KCK_PROF_CAT( a, b ) KCK_PROF_CAT_( a, b )
+
+#ifdef KCK_PROFILE
+
+#define KCK_PROF_SCOPE( name ) \
+    static const kck::prof::site *KCK_PROF_CAT( kck_prof_site_, __LINE__ ) \
+        = kck::prof::intern( name ); \
+    kck::prof::scope KCK_PROF_CAT( kck_prof_scope_, __LINE__ )( \
+        KCK_PROF_CAT( kck_prof_site_, __LINE__ ) )
+
+#define KCK_PROF_COUNT( name, k ) \
+    do { \
+        static const kck::prof::site *kck_prof_site = kck::prof::intern( name ); \
+        kck::prof::count( kck_prof_site, k ); \
+    } while ( false )
+
+#else
+
+#define KCK_PROF_SCOPE( name )
+#define KCK_PROF_COUNT( name, k ) do {} while ( false )
+
+#endif
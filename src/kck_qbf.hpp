@@ -0,0 +1,150 @@
+#pragma once
+
+#include <map>
+#include <set>
+#include <vector>
+
+#include "kck_cnf.hpp"
+#include "kck_form.hpp"
+#include "kck_log.hpp"
+#include "kck_sat.hpp"
+
+namespace kck {
+
+//// 2QBF /////////////////////////////////////////////////////////////////////
+
+// exists X . outer( X ) and forall Y . matrix( X, Y )
+//
+// Variables of the formulas which are in neither block have to be Tseitin
+// variables of the builder passed to solve_qbf2.
+template < typename lit_t >
+struct qbf2_t
+{
+    using var_t = typename lit_t::var_t;
+
+    std::vector< var_t > exists;
+    std::vector< var_t > forall;
+    formula_ptr< lit_t > outer;
+    formula_ptr< lit_t > matrix;
+};
+
+template < typename var_t >
+struct qbf2_result_t
+{
+    int res = SAT_U;
+    // The exists block, if res is SAT_Y.
+    std::map< var_t, bool > model;
+    int rounds = 0;
+};
+
+// Counterexample guided abstraction refinement with two incremental solvers.
+// The abstraction proposes X satisfying outer and the matrix instantiated
+// with every counterexample so far; the counterexample solver looks for Y
+// falsifying the matrix under X. A counterexample is instantiated on the
+// clause level: the Tseitin clauses of the matrix are simplified by Y and
+// get fresh copies of their auxiliary variables.
+template < typename lit_t >
+qbf2_result_t< typename lit_t::var_t > solve_qbf2( const qbf2_t< lit_t > &problem
+                                                 , cnf_builder< lit_t > &builder )
+{
+    using var_t = typename lit_t::var_t;
+
+    std::set< var_t > exists( problem.exists.begin(), problem.exists.end() );
+    std::set< var_t > forall( problem.forall.begin(), problem.forall.end() );
+
+    cnf_t< lit_t > matrix_cnf = problem.matrix->to_cnf( builder );
+    cnf_t< lit_t > negated_cnf = forms_t< lit_t >::f_not( problem.matrix )->to_cnf( builder );
+
+    sat_solver_t abstraction;
+    to_int_cnf_state< lit_t > abstraction_vars;
+    if ( problem.outer )
+        add_cnf( abstraction, to_int_cnf_go( problem.outer->to_cnf( builder )
+                                           , abstraction_vars ) );
+
+    sat_solver_t counter;
+    to_int_cnf_state< lit_t > counter_vars;
+    add_cnf( counter, to_int_cnf_go( negated_cnf, counter_vars ) );
+
+    std::vector< int > abstraction_x, counter_x;
+    for ( auto &x : problem.exists )
+    {
+        abstraction_x.push_back( abstraction_vars.get_int_var( { x, true } ) );
+        counter_x.push_back( counter_vars.get_int_var( { x, true } ) );
+    }
+
+    // Universal variables missing in the matrix do not matter.
+    std::vector< std::pair< var_t, int > > counter_y;
+    for ( auto &y : problem.forall )
+    {
+        auto it = counter_vars.mapping.left.find( y );
+        if ( it != counter_vars.mapping.left.end() )
+            counter_y.push_back( { y, it->second } );
+    }
+
+    qbf2_result_t< var_t > res;
+    for ( ;; )
+    {
+        res.rounds++;
+
+        int candidate = abstraction.solve();
+        if ( candidate != SAT_Y )
+        {
+            res.res = candidate;
+            return res;
+        }
+
+        for ( std::size_t i = 0; i < abstraction_x.size(); i++ )
+            counter.assume( abstraction.val( abstraction_x[ i ] ) > 0
+                          ? counter_x[ i ] : -counter_x[ i ] );
+
+        int refuted = counter.solve();
+        if ( refuted == SAT_N )
+        {
+            for ( std::size_t i = 0; i < abstraction_x.size(); i++ )
+                res.model[ problem.exists[ i ] ] = abstraction.val( abstraction_x[ i ] ) > 0;
+            res.res = SAT_Y;
+            return res;
+        }
+        if ( refuted != SAT_Y )
+            return res;
+
+        std::map< var_t, bool > y_values;
+        for ( auto &[ y, id ] : counter_y )
+            y_values[ y ] = counter.val( id ) > 0;
+
+        std::map< var_t, int > fresh;
+        for ( auto &clause : matrix_cnf )
+        {
+            std::vector< int > instance;
+            bool satisfied = false;
+            for ( auto &lit : clause )
+            {
+                if ( forall.count( lit.var ) )
+                {
+                    auto it = y_values.find( lit.var );
+                    bool value = it != y_values.end() && it->second;
+                    if ( value == lit.pos )
+                    {
+                        satisfied = true;
+                        break;
+                    }
+                }
+                else if ( exists.count( lit.var ) )
+                    instance.push_back( abstraction_vars.get_int_var( lit ) );
+                else
+                {
+                    auto [ it, inserted ] = fresh.try_emplace( lit.var, 0 );
+                    if ( inserted )
+                        it->second = abstraction_vars.label_counter++;
+                    instance.push_back( lit.pos ? it->second : -it->second );
+                }
+            }
+            if ( ! satisfied )
+                add_cnf( abstraction, instance );
+        }
+
+        debug( "qbf", "round", res.rounds, "clauses", abstraction.irredundant() );
+    }
+}
+
+}
@@ -0,0 +1,161 @@
+#include "kck_report.hpp"
+#include "kck_log.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+#include <sys/resource.h>
+#include <unistd.h>
+
+namespace kck {
+
+double cpu_seconds()
+{
+    timespec ts;
+    clock_gettime( CLOCK_PROCESS_CPUTIME_ID, &ts );
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+long peak_rss_kb()
+{
+    rusage usage;
+    getrusage( RUSAGE_SELF, &usage );
+    return usage.ru_maxrss;
+}
+
+run_report::phase_timer::phase_timer( run_report &report, std::string name )
+    : report( report )
+    , name( std::move( name ) )
+    , wall_start( std::chrono::steady_clock::now() )
+    , cpu_start( cpu_seconds() )
+{}
+
+void run_report::phase_timer::stop()
+{
+    if ( ! running )
+        return;
+    running = false;
+    std::chrono::duration< double > wall = std::chrono::steady_clock::now() - wall_start;
+    report.phases.push_back( { name, wall.count(), cpu_seconds() - cpu_start } );
+}
+
+namespace {
+
+std::string json_string( const std::string &s )
+{
+    std::stringstream ss;
+    ss << '"';
+    for ( char c : s )
+    {
+        if ( c == '"' || c == '\\' )
+            ss << '\\' << c;
+        else if ( static_cast< unsigned char >( c ) < 0x20 )
+            ss << "\\u" << std::hex << std::setw( 4 ) << std::setfill( '0' ) << int( c )
+               << std::dec;
+        else
+            ss << c;
+    }
+    ss << '"';
+    return ss.str();
+}
+
+}
+
+void run_report::write( const std::string &path ) const
+{
+    std::ofstream out( path );
+    out << std::setprecision( 12 );
+
+    out << "{\n  \"driver\": " << json_string( driver )
+        << ",\n  \"result\": " << json_string( result )
+        << ",\n  \"params\": {";
+    for ( auto it = params.begin(); it != params.end(); it++ )
+        out << ( it == params.begin() ? " " : ", " )
+            << json_string( it->first ) << ": " << json_string( it->second );
+    out << " },\n  \"phases\": [";
+    for ( std::size_t i = 0; i < phases.size(); i++ )
+        out << ( i ? ",\n" : "\n" ) << "    { \"name\": " << json_string( phases[ i ].name )
+            << ", \"wall\": " << phases[ i ].wall
+            << ", \"cpu\": " << phases[ i ].cpu << " }";
+    out << "\n  ],\n  \"peak_rss_kb\": " << peak_rss_kb();
+    for ( auto &[ section, values ] : sections )
+    {
+        out << ",\n  " << json_string( section ) << ": {";
+        for ( auto it = values.begin(); it != values.end(); it++ )
+            out << ( it == values.begin() ? " " : ", " )
+                << json_string( it->first ) << ": " << it->second;
+        out << " }";
+    }
+    out << "\n}\n";
+
+    if ( ! out )
+        throw std::runtime_error( "cannot write report " + path );
+}
+
+std::map< std::string, double > cnf_metrics( const cnf_t< int > &cnf )
+{
+    double literals = 0;
+    std::size_t max_clause_size = 0;
+    int max_var = 0;
+    for ( auto &clause : cnf )
+    {
+        literals += clause.size();
+        max_clause_size = std::max( max_clause_size, clause.size() );
+        for ( int lit : clause )
+            max_var = std::max( max_var, std::abs( lit ) );
+    }
+    return { { "clauses", cnf.size() }
+           , { "variables", max_var }
+           , { "literals", literals }
+           , { "max_clause_size", max_clause_size } };
+}
+
+std::map< std::string, double > solver_statistics( sat_solver_t &solver )
+{
+    std::map< std::string, double > stats;
+    stats[ "active" ] = solver.active();
+    stats[ "irredundant" ] = solver.irredundant();
+    stats[ "redundant" ] = solver.redundant();
+
+    // CaDiCaL only prints its statistics, so they are captured from stdout
+    // and parsed from lines like "c conflicts:   1234   56.7 per second".
+    log_flush();
+    std::cout.flush();
+    fflush( stdout );
+    FILE *capture = tmpfile();
+    if ( ! capture )
+        return stats;
+    int saved = dup( STDOUT_FILENO );
+    dup2( fileno( capture ), STDOUT_FILENO );
+    solver.statistics();
+    fflush( stdout );
+    dup2( saved, STDOUT_FILENO );
+    ::close( saved );
+
+    rewind( capture );
+    char line[ 512 ];
+    while ( fgets( line, sizeof line, capture ) )
+    {
+        std::stringstream ss( line );
+        std::string c, key;
+        double value;
+        if ( ! ( ss >> c >> key >> value ) || c != "c" || key.back() != ':' )
+            continue;
+        key.pop_back();
+        for ( const char *wanted : { "conflicts", "decisions", "propagations"
+                                   , "restarts", "reductions", "learned" } )
+            if ( key == wanted )
+                stats[ key ] = value;
+    }
+    fclose( capture );
+    return stats;
+}
+
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <chrono>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "kck_cnf.hpp"
+#include "kck_sat.hpp"
+
+namespace kck {
+
+//// Run report ///////////////////////////////////////////////////////////////
+
+// Process CPU time of all threads in seconds.
+double cpu_seconds();
+
+// Peak resident set size in kilobytes.
+long peak_rss_kb();
+
+struct phase_t
+{
+    std::string name;
+    double wall = 0;
+    double cpu = 0;
+};
+
+// Structured summary of one driver run, written as JSON:
+//
+//   { "driver": ..., "params": { ... }, "result": ...,
+//     "phases": [ { "name": ..., "wall": ..., "cpu": ... }, ... ],
+//     "peak_rss_kb": ..., "<section>": { "<key>": <number>, ... }, ... }
+struct run_report
+{
+    std::string driver;
+    std::map< std::string, std::string > params;
+    std::string result;
+    std::vector< phase_t > phases;
+    std::map< std::string, std::map< std::string, double > > sections;
+
+    run_report( std::string driver ) : driver( std::move( driver ) ) {}
+
+    // Records wall and CPU time from construction to stop() or destruction.
+    struct phase_timer
+    {
+        run_report &report;
+        std::string name;
+        std::chrono::steady_clock::time_point wall_start;
+        double cpu_start;
+        bool running = true;
+
+        phase_timer( run_report &report, std::string name );
+        phase_timer( const phase_timer& ) = delete;
+        ~phase_timer() { stop(); }
+
+        void stop();
+    };
+
+    phase_timer phase( std::string name ) { return { *this, std::move( name ) }; }
+
+    // Runs f as the phase name and returns its result.
+    template < typename fun_t >
+    auto timed( std::string name, fun_t f )
+    {
+        phase_timer timer( *this, std::move( name ) );
+        return f();
+    }
+
+    void set( const std::string &section, const std::string &key, double value )
+    {
+        sections[ section ][ key ] = value;
+    }
+
+    void set( const std::string &section, const std::map< std::string, double > &values )
+    {
+        for ( auto &[ key, value ] : values )
+            set( section, key, value );
+    }
+
+    void write( const std::string &path ) const;
+};
+
+// Clauses, variables, literals and the longest clause of a translated formula.
+std::map< std::string, double > cnf_metrics( const cnf_t< int > &cnf );
+
+// Search statistics of a solver: conflicts, decisions, propagations,
+// restarts and the like as far as CaDiCaL prints them, plus the active
+// variables and clauses.
+std::map< std::string, double > solver_statistics( sat_solver_t &solver );
+
+}
@@ -1,5 +1,21 @@
 #include "kck_sat.hpp"
 #include "kck_log.hpp"
+#include "kck_pool.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <fstream>
+#include <chrono>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <thread>
+
+#include <unistd.h>
+
+#ifdef KCK_HAVE_ZLIB
+#include <zlib.h>
+#endif
 
 namespace kck {
 
@@ -47,4 +63,409 @@ void add_cnf( sat_solver_t& sat_solver, const cnf_tree_t< int > &cnf_tree )
     }, cnf_tree );
 }
 
+//// Cube and conquer /////////////////////////////////////////////////////////
+
+namespace {
+
+void make_cubes_go( sat_solver_t &solver
+                  , const std::vector< int > &split_vars
+                  , const std::set< int > &split_set
+                  , int depth
+                  , cube_t &cube
+                  , std::vector< cube_t > &cubes )
+{
+    if ( depth == 0 )
+    {
+        cubes.push_back( cube );
+        return;
+    }
+
+    for ( int lit : cube )
+        solver.assume( lit );
+    int lit = solver.lookahead();
+
+    if ( lit == 0 )
+    {
+        // Decided under the cube, refuted cubes need no solving.
+        if ( solver.status() != SAT_N )
+            cubes.push_back( cube );
+        return;
+    }
+
+    auto in_cube = [ & ]( int var )
+    {
+        return std::any_of( cube.begin(), cube.end()
+                          , [ & ]( int l ) { return std::abs( l ) == var; } );
+    };
+
+    if ( ! split_set.count( std::abs( lit ) ) || in_cube( std::abs( lit ) ) )
+    {
+        auto it = std::find_if( split_vars.begin(), split_vars.end()
+                              , [ & ]( int var ) { return ! in_cube( var ); } );
+        if ( it == split_vars.end() )
+        {
+            cubes.push_back( cube );
+            return;
+        }
+        lit = *it;
+    }
+
+    for ( int l : { lit, -lit } )
+    {
+        cube.push_back( l );
+        make_cubes_go( solver, split_vars, split_set, depth - 1, cube, cubes );
+        cube.pop_back();
+    }
+}
+
+}
+
+std::vector< cube_t > make_cubes( sat_solver_t &solver
+                                , const std::vector< int > &split_vars
+                                , int depth )
+{
+    std::vector< cube_t > cubes;
+    cube_t cube;
+    std::set< int > split_set( split_vars.begin(), split_vars.end() );
+    make_cubes_go( solver, split_vars, split_set, depth, cube, cubes );
+    return cubes;
+}
+
+cube_result_t solve_cubes( const sat_solver_t &base
+                         , const std::vector< cube_t > &cubes
+                         , int threads
+                         , cube_progress_t progress )
+{
+    cube_result_t result;
+    if ( cubes.empty() )
+    {
+        result.res = SAT_N;
+        return result;
+    }
+
+    steal_pool< int > pool( std::min< int >( threads, cubes.size() ) );
+    for ( std::size_t i = 0; i < cubes.size(); i++ )
+        pool.push( i );
+
+    std::atomic< bool > found = false;
+    flag_terminator terminator( found );
+
+    std::vector< std::unique_ptr< sat_solver_t > > solvers;
+    for ( int w = 0; w < pool.size(); w++ )
+    {
+        solvers.push_back( std::make_unique< sat_solver_t >() );
+        base.copy( *solvers.back() );
+        solvers.back()->connect_terminator( &terminator );
+    }
+
+    std::mutex result_lock;
+    int done = 0, refuted = 0;
+
+    pool.run( [ & ]( int w, int cube )
+    {
+        sat_solver_t &solver = *solvers[ w ];
+
+        auto start = std::chrono::steady_clock::now();
+        for ( int lit : cubes[ cube ] )
+            solver.assume( lit );
+        int res = solver.solve();
+        std::chrono::duration< double > took = std::chrono::steady_clock::now() - start;
+
+        std::lock_guard< std::mutex > guard( result_lock );
+        if ( res == SAT_U )
+            return;
+
+        done++;
+        if ( res == SAT_N )
+            refuted++;
+        if ( progress )
+            progress( cube, res, took.count(), done, cubes.size() );
+
+        if ( res == SAT_Y && ! found )
+        {
+            found = true;
+            pool.halt();
+            result.res = SAT_Y;
+            result.cube = cube;
+            result.solver = std::move( solvers[ w ] );
+        }
+    } );
+
+    for ( auto &solver : solvers )
+        if ( solver )
+            solver->disconnect_terminator();
+    if ( result.solver )
+        result.solver->disconnect_terminator();
+
+    if ( ! found && refuted == static_cast< int >( cubes.size() ) )
+        result.res = SAT_N;
+    return result;
+}
+
+//// Portfolio ////////////////////////////////////////////////////////////////
+
+std::vector< sat_config_t > default_portfolio( int size )
+{
+    const char *configurations[] = { "", "sat", "unsat" };
+
+    std::vector< sat_config_t > res;
+    for ( int i = 0; i < size; i++ )
+    {
+        sat_config_t config;
+        config.configuration = configurations[ i % 3 ];
+        config.name = config.configuration.empty() ? "default" : config.configuration;
+        if ( i >= 3 )
+        {
+            config.options.push_back( { "seed", i / 3 } );
+            config.name += "-seed" + std::to_string( i / 3 );
+        }
+        res.push_back( std::move( config ) );
+    }
+    return res;
+}
+
+namespace {
+
+struct clause_copier : CaDiCaL::ClauseIterator
+{
+    sat_solver_t &solver;
+
+    clause_copier( sat_solver_t &solver ) : solver( solver ) {}
+
+    bool clause( const std::vector< int > &clause ) override
+    {
+        for ( int lit : clause )
+            solver.add( lit );
+        solver.add( 0 );
+        return true;
+    }
+};
+
+}
+
+void copy_configured( const sat_solver_t &base
+                    , sat_solver_t &solver
+                    , const sat_config_t &config )
+{
+    if ( ! config.configuration.empty()
+      && ! solver.configure( config.configuration.c_str() ) )
+        throw std::runtime_error( "unknown configuration " + config.configuration );
+
+    for ( auto &[ name, value ] : config.options )
+        if ( ! solver.set( name.c_str(), value ) )
+            throw std::runtime_error( "unknown option " + name );
+
+    clause_copier copier( solver );
+    base.traverse_clauses( copier );
+
+    // traverse_clauses only passes the units of frozen variables, the other
+    // root level assignments are copied here. vars() only reads the maximum
+    // index but is not declared const.
+    int max_var = const_cast< sat_solver_t& >( base ).vars();
+    solver.reserve( max_var );
+    for ( int v = 1; v <= max_var; v++ )
+        if ( int value = base.fixed( v ) )
+        {
+            solver.add( value > 0 ? v : -v );
+            solver.add( 0 );
+        }
+}
+
+portfolio_result_t solve_portfolio( const sat_solver_t &base
+                                  , const std::vector< sat_config_t > &configs )
+{
+    std::atomic< bool > answered = false;
+    flag_terminator terminator( answered );
+
+    std::vector< std::unique_ptr< sat_solver_t > > solvers;
+    for ( auto &config : configs )
+    {
+        solvers.push_back( std::make_unique< sat_solver_t >() );
+        copy_configured( base, *solvers.back(), config );
+        solvers.back()->connect_terminator( &terminator );
+    }
+
+    portfolio_result_t result;
+    std::mutex result_lock;
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector< std::thread > threads;
+    for ( std::size_t i = 0; i < configs.size(); i++ )
+        threads.emplace_back( [ &, i ]()
+        {
+            int res = solvers[ i ]->solve();
+            if ( res == SAT_U )
+                return;
+
+            std::lock_guard< std::mutex > guard( result_lock );
+            if ( answered )
+                return;
+            answered = true;
+
+            std::chrono::duration< double > took = std::chrono::steady_clock::now() - start;
+            result.res = res;
+            result.winner = i;
+            result.seconds = took.count();
+        } );
+
+    for ( auto &t : threads )
+        t.join();
+
+    for ( auto &solver : solvers )
+        solver->disconnect_terminator();
+    if ( result.winner >= 0 )
+        result.solver = std::move( solvers[ result.winner ] );
+    return result;
+}
+
+//// Proofs ///////////////////////////////////////////////////////////////////
+
+void write_dimacs( const std::string &path, const cnf_t< int > &cnf )
+{
+    int vars = 0;
+    for ( auto &clause : cnf )
+        for ( int lit : clause )
+            vars = std::max( vars, std::abs( lit ) );
+
+    std::ofstream out( path );
+    out << "c combox formula " << cnf_hash( cnf ) << "\n"
+        << "p cnf " << vars << " " << cnf.size() << "\n";
+    for ( auto &clause : cnf )
+    {
+        for ( int lit : clause )
+            out << lit << " ";
+        out << "0\n";
+    }
+    if ( ! out )
+        throw std::runtime_error( "cannot write " + path );
+}
+
+namespace {
+
+constexpr std::size_t proof_block = 1 << 20;
+
+// Copies everything from fd to path until the write end is closed. Keeps
+// reading after a failed write so that the solver never blocks on a full
+// pipe, but counts only what reached the file; ok is cleared on any error.
+std::uint64_t drain( int fd, const std::string &path, bool compress, bool &ok )
+{
+    std::vector< char > block( proof_block );
+    std::uint64_t total = 0;
+    ok = true;
+
+#ifdef KCK_HAVE_ZLIB
+    gzFile gz = compress ? gzopen( path.c_str(), "wb1" ) : nullptr;
+    if ( compress && ! gz )
+        ok = false;
+    if ( gz )
+        gzbuffer( gz, proof_block );
+#endif
+    std::ofstream out;
+    if ( ! compress )
+    {
+        out.open( path, std::ios::binary );
+        ok = ok && out.is_open();
+    }
+
+    ssize_t got;
+    while ( ( got = ::read( fd, block.data(), block.size() ) ) != 0 )
+    {
+        if ( got < 0 )
+        {
+            if ( errno == EINTR ) continue;
+            ok = false;
+            break;
+        }
+        if ( ! ok )
+            continue;
+#ifdef KCK_HAVE_ZLIB
+        if ( gz && gzwrite( gz, block.data(), unsigned( got ) ) != got )
+            ok = false;
+#endif
+        if ( ! compress && ! out.write( block.data(), got ) )
+            ok = false;
+        if ( ok )
+            total += got;
+    }
+
+#ifdef KCK_HAVE_ZLIB
+    if ( gz && gzclose( gz ) != Z_OK )
+        ok = false;
+#endif
+    if ( ! compress )
+    {
+        out.close();
+        ok = ok && ! out.fail();
+    }
+    ::close( fd );
+    return total;
+}
+
+}
+
+proof_sink::proof_sink( sat_solver_t &solver
+                      , const std::string &path
+                      , bool compress
+                      , bool binary )
+    : solver( solver )
+    , path( path )
+{
+#ifndef KCK_HAVE_ZLIB
+    if ( compress )
+        throw std::runtime_error( "built without zlib, cannot compress " + path );
+#endif
+
+    int fds[ 2 ];
+    if ( ::pipe( fds ) != 0 )
+        throw std::runtime_error( "cannot open a pipe for " + path );
+
+    pipe_in = fdopen( fds[ 1 ], "w" );
+    if ( ! pipe_in )
+    {
+        ::close( fds[ 0 ] );
+        ::close( fds[ 1 ] );
+        throw std::runtime_error( "cannot open a pipe for " + path );
+    }
+
+    writer = std::thread( [ this, fd = fds[ 0 ], path, compress ]()
+    {
+        written = drain( fd, path, compress, writer_ok );
+    } );
+
+    setvbuf( pipe_in, nullptr, _IOFBF, proof_block );
+
+    solver.set( "binary", binary );
+    if ( ! solver.trace_proof( pipe_in, path.c_str() ) )
+    {
+        finish();
+        throw std::runtime_error( "cannot trace proof to " + path );
+    }
+}
+
+void proof_sink::finish()
+{
+    if ( ! pipe_in )
+        return;
+    solver.close_proof_trace();
+    bool closed = fclose( pipe_in ) == 0;
+    pipe_in = nullptr;
+    writer.join();
+
+    // The writer's results are only read once it has finished.
+    bytes = written;
+    failed = failed || ! closed || ! writer_ok;
+}
+
+void proof_sink::close()
+{
+    finish();
+    if ( failed )
+        throw std::runtime_error( "cannot write proof to " + path );
+}
+
+proof_sink::~proof_sink()
+{
+    finish();
+}
+
 }
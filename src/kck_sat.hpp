@@ -1,3 +1,15 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
 #include "../inc/cadical.hpp"
 #define cdcl CaDiCaL
 
@@ -13,8 +25,133 @@ namespace kck {
 
 using sat_solver_t = CaDiCaL::Solver;
 
+void add_cnf( sat_solver_t& sat_solver, const cnf_clause_t< int > &clause );
+
 void add_cnf( sat_solver_t& sat_solver, const cnf_t< int > &cnf );
 
 void add_cnf( sat_solver_t& sat_solver, const cnf_tree_t< int > &cnf_tree );
 
+//// Termination //////////////////////////////////////////////////////////////
+
+// Stops the solver it is connected to once the flag is raised.
+struct flag_terminator : CaDiCaL::Terminator
+{
+    const std::atomic< bool > &flag;
+
+    flag_terminator( const std::atomic< bool > &flag ) : flag( flag ) {}
+
+    bool terminate() override { return flag; }
+};
+
+//// Cube and conquer /////////////////////////////////////////////////////////
+
+using cube_t = std::vector< int >;
+
+// Splits the formula of solver into cubes of depth literals over split_vars.
+// Every node picks the literal suggested by lookahead() if it is on a split
+// variable, otherwise the first split variable not in the cube yet. Cubes
+// refuted by the lookahead are dropped, so no cubes means UNSAT.
+std::vector< cube_t > make_cubes( sat_solver_t &solver
+                                , const std::vector< int > &split_vars
+                                , int depth );
+
+struct cube_result_t
+{
+    int res = SAT_U;
+    // Index of the satisfiable cube and the solver holding its model.
+    int cube = -1;
+    std::unique_ptr< sat_solver_t > solver;
+};
+
+// cube, result of the cube, seconds spent on it, cubes done, cubes total
+using cube_progress_t = std::function< void( int, int, double, int, int ) >;
+
+// Solves the cubes as assumptions on copies of base, one per thread. Stops
+// on the first satisfiable cube, the result is UNSAT iff all cubes are.
+cube_result_t solve_cubes( const sat_solver_t &base
+                         , const std::vector< cube_t > &cubes
+                         , int threads
+                         , cube_progress_t progress = {} );
+
+//// Portfolio ////////////////////////////////////////////////////////////////
+
+struct sat_config_t
+{
+    std::string name;
+    // Passed to configure(), e.g. "sat" or "unsat", empty for the default.
+    std::string configuration;
+    // Passed to set() after the configuration, e.g. { "seed", 3 }.
+    std::vector< std::pair< std::string, int > > options;
+};
+
+// The default, "sat" and "unsat" configurations followed by seeded
+// variants of them, size configurations in total.
+std::vector< sat_config_t > default_portfolio( int size );
+
+// Loads the irredundant clauses and root level units of base into a fresh
+// solver configured by config. Unlike Solver::copy this keeps the options of config, but base
+// must not have eliminated variables yet, i.e. it should not have been
+// solved or simplified.
+void copy_configured( const sat_solver_t &base
+                    , sat_solver_t &solver
+                    , const sat_config_t &config );
+
+struct portfolio_result_t
+{
+    int res = SAT_U;
+    // Index of the configuration which answered first and its solver.
+    int winner = -1;
+    double seconds = 0;
+    std::unique_ptr< sat_solver_t > solver;
+};
+
+// Runs one configured copy of base per configuration on its own thread and
+// terminates the others as soon as one of them answers.
+portfolio_result_t solve_portfolio( const sat_solver_t &base
+                                  , const std::vector< sat_config_t > &configs );
+
+//// Proofs ///////////////////////////////////////////////////////////////////
+
+// Writes cnf in DIMACS, headed by a comment with its cnf_hash. This is the
+// formula a proof traced while solving cnf has to be checked against.
+void write_dimacs( const std::string &path, const cnf_t< int > &cnf );
+
+// Streams the DRAT proof of a solver to a file. The solver writes into a
+// pipe, a background thread drains it in large blocks into the file, gzip
+// compressed if asked to, so the solver does not wait on the disk. The
+// proof is binary DRAT unless binary is false. Has to be attached while the
+// solver is still CONFIGURING, i.e. before any clause is added.
+struct proof_sink
+{
+    sat_solver_t &solver;
+    std::string path;
+    FILE *pipe_in = nullptr;
+    std::thread writer;
+
+    // Bytes which reached the file; failed is set by any error on the way.
+    // Both are valid once the proof is closed.
+    std::uint64_t bytes = 0;
+    bool failed = false;
+
+    proof_sink( sat_solver_t &solver
+              , const std::string &path
+              , bool compress
+              , bool binary = true );
+    ~proof_sink();
+
+    proof_sink( const proof_sink& ) = delete;
+    proof_sink& operator=( const proof_sink& ) = delete;
+
+    // Ends the proof and waits until all of it is on the disk; throws if
+    // any of it could not be written.
+    void close();
+
+private:
+    void finish();
+
+    // Written by the writer thread only, read after joining it.
+    std::uint64_t written = 0;
+    bool writer_ok = true;
+};
+
 }
@@ -0,0 +1,268 @@
+#include "kck_share.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+namespace kck {
+
+//// Clause ring //////////////////////////////////////////////////////////////
+
+void clause_ring::publish( const std::vector< int > &clause )
+{
+    std::uint64_t index = head.load( std::memory_order_relaxed );
+    slot_t &slot = slots[ index % slots.size() ];
+
+    // Odd sequence numbers mark a slot being written.
+    slot.seq.store( 2 * index + 1, std::memory_order_relaxed );
+    std::atomic_thread_fence( std::memory_order_release );
+
+    slot.size.store( clause.size(), std::memory_order_relaxed );
+    for ( std::size_t i = 0; i < clause.size(); i++ )
+        slot.lits[ i ].store( clause[ i ], std::memory_order_relaxed );
+
+    slot.seq.store( 2 * index + 2, std::memory_order_release );
+    head.store( index + 1, std::memory_order_release );
+}
+
+bool clause_ring::read( std::uint64_t index, std::vector< int > &clause ) const
+{
+    const slot_t &slot = slots[ index % slots.size() ];
+
+    std::uint64_t before = slot.seq.load( std::memory_order_acquire );
+    if ( before != 2 * index + 2 )
+        return false;
+
+    clause.resize( slot.size.load( std::memory_order_relaxed ) );
+    for ( std::size_t i = 0; i < clause.size(); i++ )
+        clause[ i ] = slot.lits[ i ].load( std::memory_order_relaxed );
+
+    std::atomic_thread_fence( std::memory_order_acquire );
+    return slot.seq.load( std::memory_order_relaxed ) == before;
+}
+
+//// Clause hub ///////////////////////////////////////////////////////////////
+
+clause_hub::clause_hub( int solvers, share_options_t opts )
+    : opts( opts )
+{
+    this->opts.max_size = std::min( opts.max_size, clause_ring::max_size );
+    for ( int i = 0; i < solvers; i++ )
+        rings.push_back( std::make_unique< clause_ring >( opts.capacity ) );
+}
+
+bool clause_hub::exporter::learning( int size )
+{
+    return size <= hub.opts.max_size && budget > 0;
+}
+
+void clause_hub::exporter::learn( int lit )
+{
+    if ( lit )
+    {
+        clause.push_back( lit );
+        return;
+    }
+    hub.rings[ id ]->publish( clause );
+    hub.exported++;
+    budget--;
+    clause.clear();
+}
+
+void clause_hub::import( int id
+                       , sat_solver_t &solver
+                       , std::vector< std::uint64_t > &cursors )
+{
+    std::vector< int > clause;
+    for ( std::size_t r = 0; r < rings.size(); r++ )
+    {
+        if ( static_cast< int >( r ) == id )
+            continue;
+
+        const clause_ring &ring = *rings[ r ];
+        std::uint64_t head = ring.head.load( std::memory_order_acquire );
+
+        // Skip what has been overwritten already.
+        if ( head - cursors[ r ] > ring.slots.size() )
+        {
+            lost += head - ring.slots.size() - cursors[ r ];
+            cursors[ r ] = head - ring.slots.size();
+        }
+
+        for ( ; cursors[ r ] < head; cursors[ r ]++ )
+        {
+            if ( ! ring.read( cursors[ r ], clause ) )
+            {
+                lost++;
+                continue;
+            }
+            for ( int lit : clause )
+                solver.add( lit );
+            solver.add( 0 );
+            imported++;
+        }
+    }
+}
+
+//// Sharing solver ///////////////////////////////////////////////////////////
+
+share_result_t solve_sharing( const sat_solver_t &base
+                            , int solvers
+                            , share_options_t opts )
+{
+    clause_hub hub( solvers, opts );
+
+    std::atomic< bool > answered = false;
+    flag_terminator terminator( answered );
+
+    std::vector< std::unique_ptr< sat_solver_t > > copies;
+    std::vector< std::unique_ptr< clause_hub::exporter > > exporters;
+    for ( int i = 0; i < solvers; i++ )
+    {
+        sat_config_t config;
+        config.options.push_back( { "seed", i } );
+        copies.push_back( std::make_unique< sat_solver_t >() );
+        copy_configured( base, *copies.back(), config );
+        copies.back()->connect_terminator( &terminator );
+
+        exporters.push_back( std::make_unique< clause_hub::exporter >( hub, i ) );
+        copies.back()->connect_learner( exporters.back().get() );
+    }
+
+    share_result_t result;
+    std::mutex result_lock;
+
+    std::vector< std::thread > threads;
+    for ( int i = 0; i < solvers; i++ )
+        threads.emplace_back( [ &, i ]()
+        {
+            sat_solver_t &solver = *copies[ i ];
+            std::vector< std::uint64_t > cursors( solvers, 0 );
+
+            int res = SAT_U;
+            while ( res == SAT_U && ! answered )
+            {
+                hub.import( i, solver, cursors );
+                exporters[ i ]->budget = hub.opts.per_round;
+                solver.limit( "conflicts", hub.opts.round_conflicts );
+                res = solver.solve();
+            }
+            if ( res == SAT_U )
+                return;
+
+            std::lock_guard< std::mutex > guard( result_lock );
+            if ( answered )
+                return;
+            answered = true;
+            result.res = res;
+            result.winner = i;
+        } );
+
+    for ( auto &t : threads )
+        t.join();
+
+    for ( auto &solver : copies )
+    {
+        solver->disconnect_terminator();
+        solver->disconnect_learner();
+    }
+
+    if ( result.winner >= 0 )
+        result.solver = std::move( copies[ result.winner ] );
+    result.exported = hub.exported;
+    result.imported = hub.imported;
+    result.lost = hub.lost;
+    return result;
+}
+
+//// Lemma store //////////////////////////////////////////////////////////////
+
+bool clause_collector::learning( int size )
+{
+    return size <= max_size;
+}
+
+void clause_collector::learn( int lit )
+{
+    if ( lit )
+    {
+        clause.push_back( lit );
+        return;
+    }
+    insert( std::move( clause ) );
+    clause.clear();
+}
+
+void clause_collector::insert( std::vector< int > c )
+{
+    clauses.insert( std::move( c ) );
+    if ( clauses.size() > capacity )
+        clauses.erase( std::prev( clauses.end() ) );
+}
+
+void clause_collector::merge( clause_collector &other )
+{
+    for ( auto &c : other.clauses )
+        insert( c );
+    other.clauses.clear();
+}
+
+std::string lemma_path( const std::string &dir, std::uint64_t formula_hash )
+{
+    std::stringstream ss;
+    ss << dir << "/" << std::hex << std::setw( 16 ) << std::setfill( '0' )
+       << formula_hash << ".lemmas";
+    return ss.str();
+}
+
+void save_lemmas( const std::string &path
+                , std::uint64_t formula_hash
+                , const clause_collector &lemmas )
+{
+    std::string tmp_path = path + ".tmp";
+    {
+        std::ofstream out( tmp_path );
+        out << "c combox lemmas " << formula_hash << "\n";
+        for ( auto &clause : lemmas.clauses )
+        {
+            for ( int lit : clause )
+                out << lit << " ";
+            out << "0\n";
+        }
+        if ( ! out )
+            throw std::runtime_error( "cannot write lemmas " + tmp_path );
+    }
+    if ( std::rename( tmp_path.c_str(), path.c_str() ) != 0 )
+        throw std::runtime_error( "cannot write lemmas " + path );
+}
+
+std::vector< std::vector< int > > load_lemmas( const std::string &path
+                                             , std::uint64_t formula_hash )
+{
+    std::vector< std::vector< int > > res;
+
+    std::ifstream in( path );
+    std::string c, combox, lemmas;
+    std::uint64_t hash = 0;
+    if ( ! ( in >> c >> combox >> lemmas >> hash ) || hash != formula_hash )
+        return res;
+
+    std::vector< int > clause;
+    int lit;
+    while ( in >> lit )
+    {
+        if ( lit )
+        {
+            clause.push_back( lit );
+            continue;
+        }
+        res.push_back( std::move( clause ) );
+        clause.clear();
+    }
+    return res;
+}
+
+}
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "kck_sat.hpp"
+
+namespace kck {
+
+//// Clause ring //////////////////////////////////////////////////////////////
+
+// Lock-free ring of short clauses with a single producer and any number of
+// readers. Every slot is guarded by a sequence number, so a reader can tell
+// a consistent clause from one being overwritten. Readers that fall behind
+// by more than the capacity lose the overwritten clauses.
+struct clause_ring
+{
+    static constexpr int max_size = 16;
+
+    struct slot_t
+    {
+        std::atomic< std::uint64_t > seq = 0;
+        std::atomic< int > size = 0;
+        std::array< std::atomic< int >, max_size > lits;
+    };
+
+    std::vector< slot_t > slots;
+    // Number of clauses published so far.
+    std::atomic< std::uint64_t > head = 0;
+
+    clause_ring( int capacity ) : slots( capacity ) {}
+
+    void publish( const std::vector< int > &clause );
+
+    // Reads the clause number index. Returns false if it has been
+    // overwritten in the meantime.
+    bool read( std::uint64_t index, std::vector< int > &clause ) const;
+};
+
+//// Clause hub ///////////////////////////////////////////////////////////////
+
+struct share_options_t
+{
+    // Only clauses up to this size are exported.
+    int max_size = 8;
+    // Exported clauses per solver and round.
+    int per_round = 2000;
+    // Conflicts each solver runs between two imports.
+    int round_conflicts = 20000;
+    int capacity = 1 << 14;
+};
+
+// Connects the learners of several solvers. Every solver publishes into its
+// own ring and picks up the rings of the others between rounds.
+struct clause_hub
+{
+    share_options_t opts;
+    std::vector< std::unique_ptr< clause_ring > > rings;
+
+    std::atomic< long > exported = 0;
+    std::atomic< long > imported = 0;
+    std::atomic< long > lost = 0;
+
+    clause_hub( int solvers, share_options_t opts );
+
+    // Learner of solver id, to be passed to connect_learner.
+    struct exporter : CaDiCaL::Learner
+    {
+        clause_hub &hub;
+        int id;
+        int budget = 0;
+        std::vector< int > clause;
+
+        exporter( clause_hub &hub, int id ) : hub( hub ), id( id ) {}
+
+        bool learning( int size ) override;
+        void learn( int lit ) override;
+    };
+
+    // Adds the clauses the other solvers published since the last import of
+    // solver id. cursors holds the read position in every ring.
+    void import( int id
+               , sat_solver_t &solver
+               , std::vector< std::uint64_t > &cursors );
+};
+
+struct share_result_t
+{
+    int res = SAT_U;
+    int winner = -1;
+    std::unique_ptr< sat_solver_t > solver;
+    long exported = 0;
+    long imported = 0;
+    long lost = 0;
+};
+
+// Solves solvers differently seeded copies of base on threads which
+// exchange their short learned clauses through a clause_hub. CaDiCaL has no
+// import callback, so the solvers run in rounds of round_conflicts
+// conflicts and import at the round boundaries. Learned clauses are implied
+// by base, so adding them as irredundant clauses is sound.
+share_result_t solve_sharing( const sat_solver_t &base
+                            , int solvers
+                            , share_options_t opts = {} );
+
+//// Lemma store //////////////////////////////////////////////////////////////
+
+// Collects short learned clauses of a solver. The store keeps at most
+// capacity clauses and prefers short ones. The Learner interface only
+// reports the size of a clause, not its glue, so size is the only measure.
+struct clause_collector : CaDiCaL::Learner
+{
+    struct shorter
+    {
+        bool operator()( const std::vector< int > &a
+                       , const std::vector< int > &b ) const
+        {
+            return a.size() != b.size() ? a.size() < b.size() : a < b;
+        }
+    };
+
+    int max_size;
+    std::size_t capacity;
+    std::set< std::vector< int >, shorter > clauses;
+    std::vector< int > clause;
+
+    clause_collector( int max_size = 8, std::size_t capacity = 100000 )
+        : max_size( max_size ), capacity( capacity ) {}
+
+    bool learning( int size ) override;
+    void learn( int lit ) override;
+
+    void insert( std::vector< int > c );
+    void merge( clause_collector &other );
+};
+
+// Lemmas are stored in DIMACS with a header naming the hash of the formula
+// they were learned from, so they are never loaded into another formula.
+void save_lemmas( const std::string &path
+                , std::uint64_t formula_hash
+                , const clause_collector &lemmas );
+
+// Returns the lemmas of the formula or nothing if the file is missing or
+// belongs to another formula.
+std::vector< std::vector< int > > load_lemmas( const std::string &path
+                                             , std::uint64_t formula_hash );
+
+std::string lemma_path( const std::string &dir, std::uint64_t formula_hash );
+
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <z3++.h>
+
+#include "kck_cnf.hpp"
+#include "kck_form.hpp"
+#include "kck_prof.hpp"
+
+namespace kck {
+
+//// Z3 backend ///////////////////////////////////////////////////////////////
+
+// Lowers kck formulas and CNFs to z3 expressions over one boolean constant
+// per variable, so the same instance can be handed to CaDiCaL or to Z3.
+// Shared subformulas are lowered once.
+template < typename lit_t >
+struct z3_lowering_t
+{
+    using var_t = typename lit_t::var_t;
+
+    z3::context &ctx;
+    std::map< var_t, z3::expr > vars;
+    std::map< const formula< lit_t >*, z3::expr > lowered;
+
+    z3_lowering_t( z3::context &ctx ) : ctx( ctx ) {}
+
+    z3_lowering_t( const z3_lowering_t& ) = delete;
+
+    z3::expr var( const var_t &v )
+    {
+        auto it = vars.find( v );
+        if ( it == vars.end() )
+        {
+            std::string name = "k!" + std::to_string( vars.size() );
+            it = vars.emplace( v, ctx.bool_const( name.c_str() ) ).first;
+        }
+        return it->second;
+    }
+
+    z3::expr lit( const lit_t &l )
+    {
+        return l.pos ? var( l.var ) : ! var( l.var );
+    }
+
+    z3::expr lower( const formula_ptr< lit_t > &form )
+    {
+        return lower_go( *form );
+    }
+
+    z3::expr lower( const cnf_t< lit_t > &cnf )
+    {
+        KCK_PROF_SCOPE( "z3_lower" );
+        z3::expr_vector clauses( ctx );
+        for ( auto &clause : cnf )
+        {
+            z3::expr_vector lits( ctx );
+            for ( auto &l : clause )
+                lits.push_back( lit( l ) );
+            clauses.push_back( z3::mk_or( lits ) );
+        }
+        return z3::mk_and( clauses );
+    }
+
+    // Value of v in the model, variables z3 never saw are false.
+    bool value( const z3::model &model, const var_t &v )
+    {
+        auto it = vars.find( v );
+        return it != vars.end() && model.eval( it->second, true ).is_true();
+    }
+
+    private:
+    z3::expr lower_go( const formula< lit_t > &form )
+    {
+        KCK_PROF_SCOPE( "z3_lower" );
+        auto done = lowered.find( &form );
+        if ( done != lowered.end() )
+            return done->second;
+
+        z3::expr res( ctx );
+        if ( auto l = dynamic_cast< const node_literal< lit_t >* >( &form ) )
+            res = lit( l->lit );
+        else if ( auto n = dynamic_cast< const node_not< lit_t >* >( &form ) )
+            res = ! lower_go( *n->child );
+        else if ( auto a = dynamic_cast< const node_and< lit_t >* >( &form ) )
+            res = z3::mk_and( lower_children( *a ) );
+        else if ( auto o = dynamic_cast< const node_or< lit_t >* >( &form ) )
+            res = z3::mk_or( lower_children( *o ) );
+        else
+            throw std::logic_error( "z3_lowering_t: unknown formula node" );
+
+        lowered.emplace( &form, res );
+        return res;
+    }
+
+    z3::expr_vector lower_children( const nnary_node< lit_t > &node )
+    {
+        z3::expr_vector children( ctx );
+        for ( auto &c : node.children )
+            children.push_back( lower_go( *c ) );
+        return children;
+    }
+};
+
+// A z3 solver, either the default one or the given tactics, separated by
+// commas, chained in order.
+inline z3::solver make_z3_solver( z3::context &ctx, const std::string &tactics )
+{
+    if ( tactics.empty() )
+        return z3::solver( ctx );
+
+    std::stringstream names( tactics );
+    std::string name;
+    std::getline( names, name, ',' );
+    z3::tactic chain( ctx, name.c_str() );
+    while ( std::getline( names, name, ',' ) )
+        chain = chain & z3::tactic( ctx, name.c_str() );
+    return chain.mk_solver();
+}
+
+}
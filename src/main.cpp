@@ -13,455 +13,767 @@
 #include <vector>
 #include <discreture.hpp>
 #include <map>
+#include <set>
+#include <chrono>
 #include <string>
+#include <thread>
+#include <atomic>
+#include <csignal>
+#include <cstdio>
+#include <fstream>
 
 #define SPDLOG_ACTIVE_LEVEL SPDLOG_LEVEL_DEBUG
 
 #include "spdlog/spdlog.h"
 #include "kck_log.hpp"
 #include "kck_utils.hpp"
+#include "kck_share.hpp"
+#include "kck_report.hpp"
+#include "kck_prof.hpp"
+#include "kck_z3.hpp"
 
 #include "cbx_3unihg.hpp"
+#include "cbx_canon.hpp"
+#include "cbx_hgio.hpp"
 #include "cbx_sim.hpp"
 #include "cbx_utils.hpp"
 #include "cbx_turan.hpp"
 
-#include "main.hpp"
+#include "finder.hpp"
 
-namespace kck {
+using namespace kck;
+
+//// Options //////////////////////////////////////////////////////////////////
 
-std::ostream& operator<<( std::ostream& os, const std::vector< int > &v )
+// graph_finder <n> [sat|lattice|incremental|enumerate] [--flag[=value]]...
+struct options_t
 {
-    os << "[";
-    for ( std::size_t i = 0; i < v.size(); i++ )
+    int n = 0;
+    std::string mode = "sat";
+    std::map< std::string, std::string > flags;
+
+    bool has( const std::string &key ) const
     {
-        os << v[ i ];
-        if ( i < v.size() - 1 ) os << ", ";
+        return flags.count( key ) > 0;
     }
-    return os << "]";
-}
 
-std::ostream& operator<<( std::ostream& os, const std::set< int > &s )
-{
-    os << "{";
-    for ( auto it = s.begin(); it != s.end(); it++ )
+    std::string get( const std::string &key, const std::string &def ) const
     {
-        if ( it != s.begin() ) os << ", ";
-        os << *it;
+        auto it = flags.find( key );
+        return it == flags.end() ? def : it->second;
     }
-    return os << "}";
-}
 
-}
+    // A flag given without a value keeps the default.
+    int get_int( const std::string &key, int def ) const
+    {
+        std::string value = get( key, "" );
+        return value.empty() ? def : std::stoi( value );
+    }
+};
 
-using namespace kck;
+options_t parse_options( int arc, char** argv )
+{
+    options_t opts;
+    std::vector< std::string > positional;
 
-//// Variables ////////////////////////////////////////////////////////////////
+    for ( int i = 1; i < arc; i++ )
+    {
+        std::string arg = argv[ i ];
+        if ( arg.rfind( "--", 0 ) != 0 )
+        {
+            positional.push_back( arg );
+            continue;
+        }
+        auto eq = arg.find( '=' );
+        if ( eq == std::string::npos )
+            opts.flags[ arg.substr( 2 ) ] = "";
+        else
+            opts.flags[ arg.substr( 2, eq - 2 ) ] = arg.substr( eq + 1 );
+    }
 
-lit_t labeler( int i ) { return { { 'X', { i } }, true }; }
+    if ( positional.empty() )
+        throw std::runtime_error( "usage: graph_finder <n> [sat|lattice|incremental|enumerate] [--flag[=value]]..." );
 
-formula_ptr< lit_t > llit( var_t v, bool pos )
-{
-    return forms::f_lit( { v, pos } );
+    opts.n = std::stoi( positional[ 0 ] );
+    if ( positional.size() > 1 )
+        opts.mode = positional[ 1 ];
+    return opts;
 }
 
-var_t arc_color( int i, int j, int color )
-{
-    return { 'c', { i, j, color } };
-}
+void test_b()
 
-var_t edge_present( int edge_index )
 {
-    return { 'e', { edge_index } };
+    lat_hypergraph_t h( 5 );
+
+    assert( ! is_b_uncolorable( h ) );
+
+    for ( int i = 0; i < cbx::choose( 5, 3 ); i++)
+    {
+        h.add_edge( i );
+    }
+
+    assert( is_b_uncolorable( h ) );
 }
 
-//// Coloring formula /////////////////////////////////////////////////////////
+//// Checkpoints //////////////////////////////////////////////////////////////
+
+// The lattice traversal can be interrupted and resumed. A checkpoint holds
+// the frontier of unfinished subtrees together with the state of the base
+// hypergraph, which covers exactly the finished ones.
+//
+//   combox-lattice 2
+//   n <n> split <split depth> order <order>
+//   counters <graph entered> <blue colorable>
+//   solutions <count>
+//   <edge bits, highest rank first>...
+//   frontier <count>
+//   <level> <choices>...
+//
+// Version 1 checkpoints have no order and are read as index order.
 
-cnf_t< lit_t > cnf_triangle( const palette_t &palette
-                           , int i, int j, int k, int edge_index
-                           , cnf_builder< lit_t > &builder )
+std::string edge_string( const cbx::hypergraph_t &h )
 {
-    assert( i < j && j < k );
-    forms::or_t triangle_cond;
-    // Either the edge is not present
-    triangle_cond.push( llit( edge_present( edge_index ), false ) );
-    // Or it needs at least one of the patterns
-    for ( auto &p : palette )
-        triangle_cond.push( forms::f_and(
-            { llit( arc_color( i, j, p[ 0 ] ), true )
-            , llit( arc_color( j, k, p[ 1 ] ), true )
-            , llit( arc_color( i, k, p[ 2 ] ), true ) } ) );
-    return triangle_cond.to_cnf( builder );
+    std::string bits;
+    for ( int e = h.slots(); e-- > 0; )
+        bits += h.has_edge( e ) ? '1' : '0';
+    return bits;
 }
 
-cnf_t< lit_t > cnf_triangles( const palette_t &palette, int n, cnf_builder< lit_t > builder = cnf_builder< lit_t >( labeler ) )
+cbx::hypergraph_t from_edge_string( int n, const std::string &bits )
 {
-    cnf_t< lit_t > cnf;
-
-    int edge_index = 0;
-    for ( auto &&x : discreture::combinations( n, 3 ) )
-    {
-        int i = x[ 0 ], j = x[ 1 ], k = x[ 2 ];
-        add_to( cnf, cnf_triangle( palette, i, j, k, edge_index, builder ) );
-        edge_index++;
-    }
-    return cnf;
+    cbx::hypergraph_t h( n );
+    if ( int( bits.size() ) != h.slots() )
+        throw std::runtime_error( "malformed checkpoint edges " + bits );
+    for ( int e = 0; e < h.slots(); e++ )
+        if ( bits[ h.slots() - 1 - e ] == '1' )
+            h.add_edge( e );
+    return h;
 }
 
-cnf_t< lit_t > cnf_coloring( int n, int colors )
+struct lat_checkpoint_t
+{
+    int split_depth;
+    std::string order;
+    std::vector< cbx::lat_task_t > frontier;
+};
+
+void write_checkpoint( const std::string &path
+                     , const lat_hypergraph_t &h
+                     , int split_depth
+                     , const std::string &order
+                     , const std::vector< cbx::lat_task_t > &frontier )
 {
-    cnf_t< lit_t > cnf;
-    for ( auto &&x : discreture::combinations( n, 2 ) )
+    std::string tmp_path = path + ".tmp";
     {
-        int i = x[ 0 ], j = x[ 1 ];
-        assert( i < j );
-
-        // each edge gets at least one color
-        cnf_clause_t< lit_t > clause;
-        for ( int c = 0; c < colors; c++ )
-            clause.push_back( { arc_color( i, j, c ), true } );
-        cnf.push_back( clause );
-
-        // each edge gets no more than two colors
-        for ( auto &&cc : discreture::combinations( colors, 2 ) ) {
-            if ( cc[ 0 ] == cc[ 1 ] ) continue;
-            cnf.push_back( { { arc_color( i, j, cc[ 0 ] ), false }
-                           , { arc_color( i, j, cc[ 1 ] ), false } } );
+        std::ofstream out( tmp_path );
+        out << "combox-lattice 2\n"
+            << "n " << h.n << " split " << split_depth << " order " << order << "\n"
+            << "counters " << h.counter_graph_entered
+            << " " << h.counter_blue_colorable << "\n"
+            << "solutions " << h.solutions.size() << "\n";
+        for ( auto &sol : h.solutions )
+            out << edge_string( sol ) << "\n";
+        out << "frontier " << frontier.size() << "\n";
+        for ( auto &task : frontier )
+        {
+            out << task.level << " ";
+            for ( bool c : task.choices )
+                out << ( c ? '1' : '0' );
+            out << "\n";
         }
+        if ( ! out )
+            throw std::runtime_error( "cannot write checkpoint " + tmp_path );
     }
-    return cnf;
+    // Replace the old checkpoint only once the new one is complete.
+    if ( std::rename( tmp_path.c_str(), path.c_str() ) != 0 )
+        throw std::runtime_error( "cannot write checkpoint " + path );
+    trace( "ckpt", path, "frontier", frontier.size() );
 }
 
-cnf_t< lit_t > build_coloring_cnf( 
-    int n, 
-    int colors, 
-    const palette_t &palette, 
-    cnf_builder< lit_t > builder = cnf_builder< lit_t >( labeler ) )
+lat_checkpoint_t read_checkpoint( const std::string &path, lat_hypergraph_t &h )
 {
-    cnf_t< lit_t > cnf;
-    add_to( cnf, cnf_coloring( n, colors ) );
-    add_to( cnf, cnf_triangles( palette, n, builder ) );
-    return cnf;
-}
+    std::ifstream in( path );
+    if ( ! in )
+        throw std::runtime_error( "cannot read checkpoint " + path );
 
-//// Blue coloring ////////////////////////////////////////////////////////////
+    auto expect = [ & ]( const std::string &word )
+    {
+        std::string got;
+        if ( ! ( in >> got ) || got != word )
+            throw std::runtime_error( "malformed checkpoint " + path
+                                    + ", expected " + word );
+    };
+
+    lat_checkpoint_t res;
+    int version, n;
+    std::size_t count;
+
+    expect( "combox-lattice" );
+    in >> version;
+    expect( "n" );
+    in >> n;
+    if ( ( version != 1 && version != 2 ) || n != h.n )
+        throw std::runtime_error( "checkpoint " + path + " is for another run" );
+    expect( "split" );
+    in >> res.split_depth;
+    res.order = "index";
+    if ( version == 2 )
+    {
+        expect( "order" );
+        in >> res.order;
+    }
 
-palette_t blue_palette = { { 1, 2, 3 }, { 4, 1, 5 }, { 6, 7, 1 } };
+    expect( "counters" );
+    in >> h.counter_graph_entered >> h.counter_blue_colorable;
 
-//// Graph representation /////////////////////////////////////////////////////
+    expect( "solutions" );
+    in >> count;
+    h.solutions.clear();
+    for ( std::size_t i = 0; i < count; i++ )
+    {
+        std::string bits;
+        in >> bits;
+        h.solutions.push_back( from_edge_string( n, bits ) );
+    }
 
-struct lat_hypergraph_t
-{
-    int n;
+    expect( "frontier" );
+    in >> count;
+    for ( std::size_t i = 0; i < count; i++ )
+    {
+        cbx::lat_task_t task;
+        std::string choices;
+        in >> task.level;
+        if ( task.level > 0 )
+            in >> choices;
+        for ( char c : choices )
+            task.choices.push_back( c == '1' );
+        res.frontier.push_back( std::move( task ) );
+    }
 
-    std::shared_ptr< boost::dynamic_bitset<> > edge_set;
+    if ( ! in )
+        throw std::runtime_error( "truncated checkpoint " + path );
+    return res;
+}
 
-    int counter_graph_entered = 0;
-    int counter_blue_colorable = 0;
+std::atomic< bool > *stop_flag = nullptr;
 
-    bimap< var_t, int > translation;
+void on_stop_signal( int )
+{
+    if ( stop_flag )
+        stop_flag->store( true );
+}
 
-    sat_solver_t blue_solver;
+//// Lattice solution /////////////////////////////////////////////////////////
 
-    lat_hypergraph_t( int n )
-        : n( n )
-        , edge_set( std::make_shared< boost::dynamic_bitset<> >( cbx::choose( n, 3 ) ) )
+// lattice [--threads=k] [--split=d] [--order=index|degree|palette|lemmas]
+//         [--checkpoint=path [--checkpoint-interval=seconds] [--resume]]
+//         [--lemmas=dir [--lemma-size=s]] [--minimize] [--report=path]
+void lattice_main( const options_t &opts )
+{
+    int n = opts.n;
+    int threads = opts.get_int( "threads", std::thread::hardware_concurrency() );
+    int split_depth = opts.get_int( "split", 12 );
+    std::string order = opts.get( "order", "index" );
+
+    run_report report( "lattice" );
+    report.params = { { "n", std::to_string( n ) }
+                    , { "threads", std::to_string( threads ) }
+                    , { "order", order } };
+
+    lat_hypergraph_t h( n, &report );
+    auto setup = report.phase( "setup" );
+    report.set( "cnf", "clauses", h.blue_solver.irredundant() );
+    report.set( "cnf", "variables", h.blue_solver.vars() );
+
+    std::string lemma_dir = opts.get( "lemmas", "" );
+    if ( ! lemma_dir.empty() )
     {
-        auto blue_formula = build_coloring_cnf( n, 7, blue_palette );
-        auto [ translated, translation ] = to_int_cnf( blue_formula );
-        this->translation = translation;
-        add_cnf( blue_solver, translated );
+        auto stored = load_lemmas( lemma_path( lemma_dir, h.blue_hash ), h.blue_hash );
+        h.warm_start( stored, opts.get_int( "lemma-size", 8 ) );
+        trace( "lemmas", "loaded", stored.size() );
     }
 
-    void add_edge( int index )
-    {
-        ( *edge_set )[ index ] = true;
-    }
+    h.set_order( make_lat_order( order, h ) );
+    if ( h.order->uses_model() && ( threads > 1 || opts.has( "checkpoint" ) ) )
+        throw std::runtime_error( "the " + order + " order needs --threads=1 and no checkpoint" );
 
-    void remove_edge( int index )
+    auto store_lemmas = [ & ]()
     {
-        ( *edge_set )[ index ] = false;
-    }
-
-    int solve_blue()
+        if ( ! h.lemmas )
+            return;
+        save_lemmas( lemma_path( lemma_dir, h.blue_hash ), h.blue_hash, *h.lemmas );
+        trace( "lemmas", "stored", h.lemmas->clauses.size() );
+    };
+    setup.stop();
+
+    auto traversal = report.phase( "traversal" );
+    if ( threads <= 1 && ! opts.has( "checkpoint" ) )
+        cbx::trav_3hg_lat( h
+                         , is_b_uncolorable
+                         , is_r_uncolorable
+                         , print_graph );
+    else
     {
-        for ( int i = 0; i < cbx::choose( n, 3 ); i++ )
-        {
-            int edge_var = translation.left.at( edge_present( i ) );
-            blue_solver.assume( ( *edge_set )[ i ] ? edge_var : - edge_var );
-        }
-        return blue_solver.solve();
-    }
+        cbx::lat_control_t control;
 
-    cbx::hypergraph_t to_hypergraph() const
-    {
-        std::set< std::set< int > > edges;
-        int counter = 0;
-        for ( auto &x : discreture::combinations( n, 3 ) )
+        std::string path = opts.get( "checkpoint", "" );
+        if ( ! path.empty() )
         {
-            if ( ( *edge_set )[ counter ] )
-                edges.insert( { x[ 0 ], x[ 1 ], x[ 2 ] } );
-            counter++;
+            if ( opts.has( "resume" ) )
+            {
+                auto ckpt = read_checkpoint( path, h );
+                if ( ckpt.order != order )
+                    throw std::runtime_error( "checkpoint " + path + " was written with --order="
+                                            + ckpt.order );
+                split_depth = ckpt.split_depth;
+                control.resume = std::move( ckpt.frontier );
+                trace( "ckpt", "resuming", path, "frontier", control.resume->size() );
+            }
+            control.interval = std::chrono::seconds(
+                    opts.get_int( "checkpoint-interval", 600 ) );
+            control.checkpoint = [ & ]( const std::vector< cbx::lat_task_t > &f )
+            {
+                write_checkpoint( path, h, split_depth, order, f );
+                store_lemmas();
+            };
         }
 
-        return { n, std::move( edges ) };
-    }
+        stop_flag = &control.stop;
+        std::signal( SIGINT, on_stop_signal );
+        std::signal( SIGTERM, on_stop_signal );
 
-};
-
-std::ostream& operator<<( std::ostream& os, const lat_hypergraph_t& h )
-{
-    return os << h.to_hypergraph();
-}
-
-//// Red coloring /////////////////////////////////////////////////////////////
+        cbx::trav_3hg_lat_par( h
+                             , threads
+                             , split_depth
+                             , is_b_uncolorable
+                             , is_r_uncolorable
+                             , print_graph
+                             , &control );
 
+        std::signal( SIGINT, SIG_DFL );
+        std::signal( SIGTERM, SIG_DFL );
+        stop_flag = nullptr;
 
-bool is_perm_colorable( const lat_hypergraph_t &h, const std::vector< int > &perm )
-{
-    int n = h.n;
-
-    std::vector< unsigned int > roles( h.n * h.n, 0 );
+        if ( control.stop )
+        {
+            trace( "ckpt", "interrupted" );
+            report.result = "interrupted";
+        }
+    }
+    traversal.stop();
 
-    int counter = 0;
+    trace( "count", "order", order );
+    trace( "count", "graphs visited", h.counter_graph_entered );
+    trace( "count", "graphs blue colorable", h.counter_blue_colorable );
+    trace( "count", "graphs found", h.solutions.size() );
 
-    // This uses the fact, that the edge_set is created using the very same
-    // discreture::combinations this is rather ugly and should be fixed.
-    for ( auto &&p : discreture::combinations( n, 3 ) )
+    if ( opts.has( "minimize" ) )
     {
-        if ( ( *h.edge_set )[ counter ] )
+        auto minimize = report.phase( "minimization" );
+        for ( auto &sol : h.solutions )
         {
-            int i = perm[ p[ 0 ] ], j = perm[ p[ 1 ] ], k = perm[ p[ 2 ] ];
-            cbx::sort_i( i, j, k );
-            assert( i < j && j < k );
-            // The arc serves as left edge
-            roles[ cbx::adj_i( n, i, j ) ] |= 1;
-            // The arc serves as right edge
-            roles[ cbx::adj_i( n, j, k ) ] |= 2;
-            // The arc serves as top edge
-            roles[ cbx::adj_i( n, i, k ) ] |= 4;
+            h.graph = sol;
+            minimize_stats_t stats;
+            minimize_witness( h, &stats );
+            trace( "min", h.graph, field( "edges", h.graph.edge_count() )
+                 , field( "from", sol.edge_count() ), field( "red_checks", stats.red_checks )
+                 , field( "cache_hits", stats.cache_hits ), field( "seconds", stats.seconds ) );
         }
-        counter += 1;
     }
 
-    for ( auto v : roles )
-        // If any arc serves as both left, top, right
-        if ( v == 7 )
-            return false;
-    return true;
+    store_lemmas();
+
+    std::string report_path = opts.get( "report", "" );
+    if ( report_path.empty() )
+        return;
+    if ( report.result.empty() )
+        report.result = "complete";
+    report.set( "counters", "graphs_visited", h.counter_graph_entered );
+    report.set( "counters", "graphs_blue_colorable", h.counter_blue_colorable );
+    report.set( "counters", "graphs_found", h.solutions.size() );
+    // Workers search on copies, only a sequential run uses h.blue_solver.
+    if ( threads <= 1 && ! opts.has( "checkpoint" ) )
+        report.set( "solver", solver_statistics( h.blue_solver ) );
+    else
+        report.set( "solver", h.worker_stats );
+    report.write( report_path );
 }
 
+//// SATting solution /////////////////////////////////////////////////////////
 
-bool is_r_uncolorable( lat_hypergraph_t &h )
-{
-    for ( auto &&perm : discreture::permutations( h.n ) )
-        if ( is_perm_colorable( h, perm ) ) return false;
-    return true;
-}
-
-using coloring_t = std::map< std::pair< int, int >, int >;
-
-coloring_t get_coloring_solution( const lat_hypergraph_t &h
-                                , int colors
-                                , sat_solver_t &solver )
+// The same instance on Z3: the blue CNF and the red formula tree are
+// lowered to z3 expressions as they are.
+void satting_z3( const options_t &opts
+               , run_report &report
+               , const cnf_t< lit_t > &blue
+               , const forms::form_p &red )
 {
-    coloring_t coloring;
-
-    int n = h.n;
+    int n = opts.n;
+    if ( opts.has( "cubes" ) || opts.has( "portfolio" ) || opts.has( "share" )
+      || opts.has( "proof" ) )
+        throw std::runtime_error( "the z3 backend only solves sequentially" );
 
-    const bimap< var_t, int > &translation = h.translation;
+    z3::context ctx;
+    z3_lowering_t< lit_t > lowering( ctx );
+    z3::solver solver = make_z3_solver( ctx, opts.get( "tactics", "" ) );
 
-    for ( auto &a : discreture::combinations( n, 2 ) )
-        for ( int c = 0; c < colors; c++ )
-            if ( solver.val( translation.left.at( arc_color( a[ 0 ], a[ 1 ], c ) ) ) > 0 )
-                coloring.insert( { { a[ 0 ], a[ 1 ] }, c } );
-
-    return coloring;
+    report.timed( "lowering", [ & ]()
+    {
+        solver.add( lowering.lower( blue ) );
+        solver.add( lowering.lower( red ) );
+    } );
+
+    auto res = report.timed( "solve", [ & ]() { return solver.check(); } );
+
+    if ( res == z3::sat )
+        trace( "sol", report.timed( "model read", [ & ]()
+              {
+                  auto model = solver.get_model();
+                  cbx::hypergraph_t g( n );
+                  for ( int index = 0; index < g.slots(); index++ )
+                      if ( lowering.value( model, edge_present( index ) ) )
+                          g.add_edge( index );
+                  return g;
+              } ) );
+    else if ( res == z3::unsat )
+        trace( "sol", "no solution found" );
+    else
+        trace( "sol", "unknown", solver.reason_unknown() );
+
+    std::string report_path = opts.get( "report", "" );
+    if ( report_path.empty() )
+        return;
+    report.result = res == z3::sat ? "sat" : res == z3::unsat ? "unsat" : "unknown";
+    report.set( "cnf", "clauses", blue.size() );
+    report.set( "cnf", "variables", lowering.vars.size() );
+    auto stats = solver.statistics();
+    for ( unsigned i = 0; i < stats.size(); i++ )
+        report.set( "solver", stats.key( i )
+                  , stats.is_uint( i ) ? stats.uint_value( i ) : stats.double_value( i ) );
+    report.write( report_path );
 }
 
-void print_graph( lat_hypergraph_t &h )
+// sat [--cubes[=depth] [--threads=k] | --portfolio[=size] | --share[=solvers]]
+//     [--proof=prefix [--proof-gzip] [--proof-text]]
+//     [--backend=cadical|z3 [--tactics=t1,t2,...]] [--report=path]
+void satting_main( const options_t &opts )
 {
-    std::cout << h.to_hypergraph() << std::endl;
+    int n = opts.n;
+    std::string backend = opts.get( "backend", "cadical" );
 
-    int res = h.solve_blue();
-    assert( res == SAT_Y );
+    run_report report( "sat" );
+    report.params = { { "n", std::to_string( n ) }, { "backend", backend } };
+    for ( const char *mode : { "cubes", "portfolio", "share", "proof", "tactics" } )
+        if ( opts.has( mode ) )
+            report.params[ mode ] = opts.get( mode, "" );
 
-    coloring_t coloring = get_coloring_solution( h, 7, h.blue_solver );
+    cnf_builder< lit_t > builder( labeler );
 
-    //show( std::cout, h.blue_orig, true );
+    cnf_t< lit_t > formula;
 
-    for ( const auto &[ key, item ] : coloring )
-    {
-        std::cout << key << "->" << item << std::endl;
-    }
-}
+    auto build = report.phase( "formula build" );
+    // Add existence of a blue coloring 
+    add_to( formula, build_coloring_cnf( n, 7, blue_palette, builder ) );
 
-bool is_b_uncolorable( lat_hypergraph_t &h )
-{
-    if ( h.counter_graph_entered % 100000 == 0 )
+    debug( "dbg", "blue formula done" );
+    // Add non-existence of a red coloring
+    auto red = red_uncolor_formula( n );
+    if ( backend == "z3" )
     {
-        trace( "sts", h.counter_graph_entered, h.counter_blue_colorable, *h.edge_set );
+        build.stop();
+        satting_z3( opts, report, formula, red );
+        return;
     }
-    h.counter_graph_entered++;
+    if ( backend != "cadical" )
+        throw std::runtime_error( "unknown backend " + backend );
 
-    //trace( "edges", *h.edge_set );
+    add_to( formula, red->to_cnf( builder ) );
+    debug( "dbg", "red formula done" );
+    build.stop();
 
-    int res = h.solve_blue();
-    if ( res == SAT_U ) throw std::runtime_error( "sat does not know" );
+    auto [ translated, translation ] = report.timed( "int translation"
+                                                   , [ & ]() { return to_int_cnf( formula ); } );
+    debug( "dbg", "cnf done" );
 
-    if ( res == SAT_Y )
-        h.counter_blue_colorable ++;
+    trace( "cnf", cnf_get_stats( formula ) );
+    
+    sat_solver_t solver;
 
-    return res == SAT_N;
-}
+    // The proof is written to <prefix>.drat and checked against the
+    // formula written to <prefix>.cnf.
+    std::unique_ptr< proof_sink > proof;
+    std::string proof_prefix = opts.get( "proof", "" );
+    if ( ! proof_prefix.empty() )
+    {
+        if ( opts.has( "cubes" ) || opts.has( "portfolio" ) || opts.has( "share" ) )
+            throw std::runtime_error( "proofs are only traced by the sequential solver" );
+
+        write_dimacs( proof_prefix + ".cnf", translated );
+        bool gzip = opts.has( "proof-gzip" );
+        proof = std::make_unique< proof_sink >( solver
+                                              , proof_prefix + ( gzip ? ".drat.gz" : ".drat" )
+                                              , gzip
+                                              , ! opts.has( "proof-text" ) );
+    }
 
-void test_b()
+    report.timed( "add_cnf", [ & ]() { add_cnf( solver, translated ); } );
 
-{
-    lat_hypergraph_t h( 5 );
+    int res = SAT_U;
+    // Parallel modes answer on a copy of solver.
+    std::unique_ptr< sat_solver_t > winner;
 
-    assert( ! is_b_uncolorable( h ) );
+    auto solve = report.phase( "solve" );
+    if ( opts.has( "cubes" ) )
+    {
+        std::vector< int > edge_vars;
+        for ( int i = 0; i < cbx::choose( n, 3 ); i++ )
+            edge_vars.push_back( translation.left.at( edge_present( i ) ) );
+
+        auto cubes = make_cubes( solver, edge_vars, opts.get_int( "cubes", 8 ) );
+        trace( "cube", "cubes", cubes.size() );
+
+        auto cubed = solve_cubes( solver
+                                , cubes
+                                , opts.get_int( "threads", std::thread::hardware_concurrency() )
+                                , []( int cube, int res, double seconds, int done, int total )
+                                  {
+                                      trace( "cube", cube, res == SAT_Y ? "sat" : "unsat"
+                                           , seconds, "s", done, "/", total );
+                                  } );
+        res = cubed.res;
+        winner = std::move( cubed.solver );
+    }
+    else if ( opts.has( "portfolio" ) )
+    {
+        auto configs = default_portfolio(
+                opts.get_int( "portfolio", std::thread::hardware_concurrency() ) );
+        auto raced = solve_portfolio( solver, configs );
+        res = raced.res;
+        if ( raced.winner >= 0 )
+            trace( "portfolio", "winner", configs[ raced.winner ].name
+                 , raced.seconds, "s" );
+        winner = std::move( raced.solver );
+    }
+    else if ( opts.has( "share" ) )
+    {
+        share_options_t share;
+        share.max_size = opts.get_int( "share-size", share.max_size );
+        share.per_round = opts.get_int( "share-rate", share.per_round );
+        auto shared = solve_sharing(
+                solver
+              , opts.get_int( "share", std::thread::hardware_concurrency() )
+              , share );
+        res = shared.res;
+        trace( "share", "exported", shared.exported, "imported", shared.imported
+             , "lost", shared.lost );
+        winner = std::move( shared.solver );
+    }
+    else
+        res = solver.solve();
+    solve.stop();
 
-    for ( int i = 0; i < cbx::choose( 5, 3 ); i++)
+    if ( proof )
     {
-        h.add_edge( i );
+        proof->close();
+        trace( "proof", proof_prefix, proof->bytes, "bytes" );
     }
 
-    assert( is_b_uncolorable( h ) );
+    if ( res == SAT_Y )
+        trace( "sol", report.timed( "model read", [ & ]()
+              {
+                  return read_hypergraph( n, winner ? *winner : solver, translation );
+              } ) );
+    else if ( res == SAT_N ) 
+        trace( "sol", "no solution found" );
+    else 
+        trace( "sol", "unknown" );
+
+    std::string report_path = opts.get( "report", "" );
+    if ( report_path.empty() )
+        return;
+    report.result = res == SAT_Y ? "sat" : res == SAT_N ? "unsat" : "unknown";
+    report.set( "cnf", cnf_metrics( translated ) );
+    report.set( "solver", solver_statistics( winner ? *winner : solver ) );
+    report.write( report_path );
 }
 
-//// Lattice solution /////////////////////////////////////////////////////////
+//// Enumeration ////////////////////////////////////////////////////////////
 
-void lattice_main( int n )
+// enumerate [--out=path] [--flush=seconds] [--orbit-cap=k] [--limit=k]
+//           [--report=path]
+//
+// Keeps solving the sat formula. Every model is blocked together with up to
+// orbit-cap graphs isomorphic to it, by one clause over the edge variables
+// each, and its canonical form is written unless the class was seen
+// already, which only happens once orbits are cut off by the cap. The
+// classes go to a cbx_hgio file, cbx_hgconv turns it into text.
+//
+// An orbit has n! / |Aut( g )| graphs, so with the default cap each model
+// adds up to 5040 blocking clauses of C( n, 3 ) literals, about 0.6M
+// literals at n = 9; a lower cap trades them for more models per class.
+void enumerate_main( const options_t &opts )
 {
-    lat_hypergraph_t h( n );
-
-    cbx::trav_3hg_lat( h
-                     , is_b_uncolorable
-                     , is_r_uncolorable
-                     , print_graph );
+    int n = opts.n;
+    std::size_t orbit_cap = opts.get_int( "orbit-cap", 5040 );
+    long limit = opts.get_int( "limit", 0 );
+    auto flush_interval = std::chrono::seconds( opts.get_int( "flush", 10 ) );
 
-    trace( "count", "graphs visited", h.counter_graph_entered );
-    trace( "count", "graphs blue colorable", h.counter_blue_colorable );
-}
-
-//// SATting solution /////////////////////////////////////////////////////////
+    run_report report( "enumerate" );
+    report.params = { { "n", std::to_string( n ) }
+                    , { "orbit-cap", std::to_string( orbit_cap ) } };
 
-var_t role_label( int p, int i, int j, int role )
-{
-    return { 'f', { p, i, j, role } };
-}
+    auto build = report.phase( "formula build" );
+    cnf_builder< lit_t > builder( labeler );
+    cnf_t< lit_t > formula;
+    add_to( formula, build_coloring_cnf( n, 7, blue_palette, builder ) );
+    add_to( formula, red_uncolor_formula( n )->to_cnf( builder ) );
+    auto [ translated, translation ] = to_int_cnf( formula );
 
-forms::form_p red_uncolor_formula( int n )
-{
+    sat_solver_t solver;
+    add_cnf( solver, translated );
 
-    // Each ordering of the vertices needs one arc, which is uncolorable.
-    forms::and_t all_orderings_uncolorable;
+    std::vector< int > edge_vars;
+    for ( int i = 0; i < cbx::choose( n, 3 ); i++ )
+        edge_vars.push_back( translation.left.at( edge_present( i ) ) );
+    build.stop();
 
-    int perm_index = 0;
+    cbx::hg_writer_t out( opts.get( "out", "solutions.hg" ), n );
+    std::set< boost::dynamic_bitset<> > classes;
+    long models = 0, blocking = 0;
 
-    for ( auto &&p : discreture::permutations( n ) )
+    using clock = std::chrono::steady_clock;
+    auto start = clock::now(), last_flush = start;
+    auto rate = [ & ]()
     {
+        std::chrono::duration< double > took = clock::now() - start;
+        return classes.size() / std::max( took.count(), 1e-9 );
+    };
 
-        // Go through the edges and label roles of the arcs.  
-        forms::and_t roles;
-
-        int edge_index = 0;
+    auto search = report.phase( "enumeration" );
+    int res;
+    while ( ( res = solver.solve() ) == SAT_Y )
+    {
+        models++;
+        cbx::hypergraph_t g( n );
+        for ( std::size_t i = 0; i < edge_vars.size(); i++ )
+            if ( solver.val( edge_vars[ i ] ) > 0 )
+                g.add_edge( i );
 
-        for ( auto &&c : discreture::combinations( n, 3 ) )
+        for ( auto &image : cbx::orbit( g, orbit_cap ) )
         {
-            // edge_index represents the edge i, j, k 
-            // if edge with edge_index is on, ijk is in the graph
-            int pi = p[ c[ 0 ] ], pj = p[ c[ 1 ] ], pk = p[ c[ 2 ] ];
-
-            // This makes sure, we are adding the arcs in correct order 
-            // *with respect to the order of the permuted graph*. This 
-            // sorting is precisely the thing, which changes the order 
-            // of the graph. 
-            cbx::sort_i( pi, pj, pk );
-            assert( pi < pj && pj < pk );
-
-            roles.push( 
-                forms::f_imp( llit( edge_present( edge_index ), true )
-                            , forms::f_and( { llit( role_label( perm_index, pi, pj, 1 )
-                                                  , true )
-                                            , llit( role_label( perm_index, pj, pk, 2 )
-                                                  , true )
-                                            , llit( role_label( perm_index, pi, pk, 3 )
-                                                  , true ) } ) ) );
-            edge_index++;
+            cnf_clause_t< int > clause;
+            for ( std::size_t i = 0; i < edge_vars.size(); i++ )
+                clause.push_back( image.has_edge( i ) ? -edge_vars[ i ] : edge_vars[ i ] );
+            add_cnf( solver, clause );
+            blocking++;
         }
 
-        // A problem happens, if at least one arcs has all three roles.
-        forms::or_t problem;
-        for ( auto &&c : discreture::combinations( n, 2 ) )
+        auto canon = cbx::canonical_form( g );
+        if ( classes.insert( canon.edges ).second )
+            out.write( cbx::graph_of( n, canon.edges ) );
+
+        if ( clock::now() - last_flush >= flush_interval )
         {
-            int i = c[ 0 ], j = c[ 1 ];
-            assert( i < j );
-            problem.push( forms::f_or( { llit( role_label( perm_index, i, j, 1 )
-                                             , true )
-                                       , llit( role_label( perm_index, i, j, 1 )
-                                             , true )
-                                       , llit( role_label( perm_index, i, j, 1 )
-                                             , true ) } ) );
+            out.flush();
+            last_flush = clock::now();
+            trace( "enum", field( "classes", classes.size() ), field( "models", models )
+                 , field( "per_s", rate() ) );
         }
-
-        all_orderings_uncolorable.push( roles );
-        all_orderings_uncolorable.push( problem );
-
-        perm_index++;
+        if ( limit && long( classes.size() ) >= limit )
+            break;
     }
-
-    return std::make_shared< forms::and_t >( all_orderings_uncolorable );
-
+    out.close();
+    search.stop();
+
+    trace( "enum", res == SAT_N ? "complete" : "stopped"
+         , field( "classes", classes.size() ), field( "models", models )
+         , field( "blocking", blocking ), field( "per_s", rate() ) );
+
+    std::string report_path = opts.get( "report", "" );
+    if ( report_path.empty() )
+        return;
+    report.result = res == SAT_N ? "complete" : res == SAT_Y ? "limit" : "unknown";
+    report.set( "enumeration", "classes", classes.size() );
+    report.set( "enumeration", "models", models );
+    report.set( "enumeration", "blocking_clauses", blocking );
+    report.set( "enumeration", "classes_per_second", rate() );
+    report.set( "cnf", cnf_metrics( translated ) );
+    report.set( "solver", solver_statistics( solver ) );
+    report.write( report_path );
 }
 
-cbx::hypergraph_t read_hypergraph( int n
-                            , sat_solver_t &solver
-                            , bimap< var_t, int > translation )
-{
-    int index = 0;
-    std::set< std::set< int > > edges;
-    for ( auto &c : discreture::combinations( n, 3 ) )
-    {
-        if ( solver.val( translation.left.at( edge_present( index ) ) ) > 0 ) 
-            edges.insert( { c[ 0 ], c[ 1 ], c[ 2 ] } );
-        index ++;
-    }
-    return { n, edges };
-}
+//// Incremental solution ///////////////////////////////////////////////////
 
-void satting_main( int n )
+// incremental [--from=k] [--report=path]
+//
+// Looks for the smallest n up to the given one on a single solver. Going
+// from n to n + 1 adds the arcs and triangles of the new vertex to the blue
+// formula, which only grows. The red formula of n is added with its top
+// literal guarded by the activation literal of n, which is assumed while n
+// is solved and fixed to false once n is refuted. Learned clauses stay
+// valid and are kept.
+void incremental_main( const options_t &opts )
 {
+    int from = opts.get_int( "from", 4 );
 
-    cnf_builder< lit_t > builder( labeler );
-
-    cnf_t< lit_t > formula;
-
-    // Add existence of a blue coloring 
-    add_to( formula, build_coloring_cnf( n, 7, blue_palette, builder ) );
-
-    trace( "dbg", "blue formula done" );
-    // Add non-existence of a red coloring
-    add_to( formula, red_uncolor_formula( n )->to_cnf( builder ) );
-    trace( "dbg", "red formula done" );
-
-    auto [ translated, translation ] = to_int_cnf( formula );
-    trace( "dbg", "cnf done" );
+    run_report report( "incremental" );
+    report.params = { { "n", std::to_string( opts.n ) }
+                    , { "from", std::to_string( from ) } };
 
-    trace( "cnf", cnf_get_stats( formula ) );
-    
+    cnf_builder< lit_t > builder( labeler );
+    to_int_cnf_state< lit_t > translation;
     sat_solver_t solver;
-    add_cnf( solver, translated );
 
-    int res = solver.solve();
+    int res = SAT_N;
+    int n = 0;
+    while ( res == SAT_N && n < opts.n )
+    {
+        n++;
+        auto grow = report.phase( "n=" + std::to_string( n ) + " formula build" );
+        add_cnf( solver, to_int_cnf_go(
+                    build_coloring_cnf_vertex( n - 1, 7, blue_palette, builder )
+                  , translation ) );
+        if ( n < from )
+            continue;
+
+        lit_t active = { { 'a', { n } }, true };
+        lit_t red_top = red_uncolor_formula( n )->to_cnf_go( builder );
+        cnf_t< lit_t > red = std::move( builder.output );
+        builder.output.clear();
+        red.push_back( { -active, red_top } );
+        add_cnf( solver, to_int_cnf_go( red, translation ) );
+        grow.stop();
+
+        int active_var = translation.get_int_var( active );
+        auto solve = report.phase( "n=" + std::to_string( n ) + " solve" );
+        solver.assume( active_var );
+        res = solver.solve();
+        solve.stop();
+
+        trace( "incr", n, res == SAT_Y ? "sat" : res == SAT_N ? "unsat" : "unknown"
+             , field( "clauses", solver.irredundant() )
+             , field( "learned", solver.redundant() ) );
+
+        if ( res == SAT_N )
+            add_cnf( solver, cnf_clause_t< int >{ -active_var } );
+    }
 
     if ( res == SAT_Y )
-        trace( "sol", read_hypergraph( n, solver, translation ) );
-    else if ( res == SAT_N ) 
-        trace( "sol", "no solution found" );
-    else 
+        trace( "sol", n, read_hypergraph( n, solver, translation.mapping ) );
+    else if ( res == SAT_N )
+        trace( "sol", "no solution found up to", opts.n );
+    else
         trace( "sol", "unknown" );
+
+    std::string report_path = opts.get( "report", "" );
+    if ( report_path.empty() )
+        return;
+    report.result = res == SAT_Y ? "sat" : res == SAT_N ? "unsat" : "unknown";
+    report.set( "incremental", "last_n", n );
+    report.set( "cnf", "clauses", solver.irredundant() );
+    report.set( "cnf", "variables", solver.vars() );
+    report.set( "solver", solver_statistics( solver ) );
+    report.write( report_path );
 }
 
 //// Main /////////////////////////////////////////////////////////////////////
@@ -469,8 +781,15 @@ void satting_main( int n )
 int main( int arc, char** argv )
 {
 
-    int n = std::stoi( argv[ 1 ] );
+    options_t opts = parse_options( arc, argv );
 
-    satting_main( n );
+    if ( opts.mode == "lattice" )
+        lattice_main( opts );
+    else if ( opts.mode == "incremental" )
+        incremental_main( opts );
+    else if ( opts.mode == "enumerate" )
+        enumerate_main( opts );
+    else
+        satting_main( opts );
 
 }
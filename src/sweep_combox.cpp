@@ -0,0 +1,258 @@
+// Scaling sweep over n for the finder engines.
+//
+// sweep_combox [--from=5] [--to=8] [--run="sat --backend=z3"]...
+//              [--time=seconds] [--memory=megabytes] [--out=sweep.csv]
+//              [--bin=directory]
+//
+// Every run is a fresh graph_finder or graph_finder_z3 process, started
+// with its address space limited and killed once it exceeds the wall time
+// cap. There is no CPU time limit, which multi-threaded runs would exhaust
+// in a fraction of the wall time cap. A run is given as the engine (sat, lattice or z3)
+// followed by its flags; the default runs are "sat", "lattice" and "z3".
+// The measurements come from wait4 and from the JSON report every run
+// writes. At the end, the growth per step of n of time and memory is fitted
+// for every run configuration.
+
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+//// Runs /////////////////////////////////////////////////////////////////////
+
+struct sweep_options_t
+{
+    int from = 5;
+    int to = 8;
+    std::vector< std::string > runs;
+    double time_cap = 3600;
+    long memory_mb = 16384;
+    std::string out = "sweep.csv";
+    std::string bin;
+};
+
+struct measurement_t
+{
+    std::string config;
+    int n;
+    std::string status;   // ok, timeout, memout or error
+    std::string result;
+    double wall = 0;
+    double cpu = 0;
+    long peak_rss_kb = 0;
+    double clauses = -1;
+    double variables = -1;
+};
+
+std::vector< std::string > split_words( const std::string &s )
+{
+    std::istringstream in( s );
+    std::vector< std::string > words;
+    for ( std::string w; in >> w; )
+        words.push_back( w );
+    return words;
+}
+
+// Value of the first "key": in a report, good enough for its flat layout.
+std::string report_value( const std::string &json, const std::string &key )
+{
+    auto at = json.find( "\"" + key + "\":" );
+    if ( at == std::string::npos )
+        return "";
+    at = json.find_first_not_of( " ", at + key.size() + 3 );
+    if ( json[ at ] == '"' )
+        return json.substr( at + 1, json.find( '"', at + 1 ) - at - 1 );
+    return json.substr( at, json.find_first_of( ",}\n", at ) - at );
+}
+
+measurement_t run_once( const sweep_options_t &opts, const std::string &config, int n )
+{
+    measurement_t m{ config, n, "error", "", 0, 0, 0, -1, -1 };
+
+    auto words = split_words( config );
+    std::string engine = words.at( 0 );
+    std::string report = "sweep_" + std::to_string( getpid() ) + ".json";
+    std::remove( report.c_str() );
+
+    std::vector< std::string > args;
+    if ( engine == "z3" )
+    {
+        args = { opts.bin + "/graph_finder_z3", std::to_string( n ), report };
+        args.insert( args.end(), words.begin() + 1, words.end() );
+    }
+    else
+    {
+        args = { opts.bin + "/graph_finder", std::to_string( n ), engine };
+        args.insert( args.end(), words.begin() + 1, words.end() );
+        args.push_back( "--report=" + report );
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    pid_t pid = fork();
+    if ( pid < 0 )
+        throw std::runtime_error( "fork failed" );
+
+    if ( pid == 0 )
+    {
+        rlim_t bytes = rlim_t( opts.memory_mb ) << 20;
+        rlimit as{ bytes, bytes };
+        setrlimit( RLIMIT_AS, &as );
+
+        // The engines log to stdout, which the sweep keeps for itself.
+        int null = open( "/dev/null", O_WRONLY );
+        if ( null < 0 || dup2( null, STDOUT_FILENO ) < 0 )
+            _exit( 127 );
+        ::close( null );
+
+        std::vector< char* > argv;
+        for ( auto &a : args )
+            argv.push_back( const_cast< char* >( a.c_str() ) );
+        argv.push_back( nullptr );
+        execv( argv[ 0 ], argv.data() );
+        _exit( 127 );
+    }
+
+    // Only the wall time is capped.
+    int status = 0;
+    rusage usage{};
+    bool timed_out = false;
+    for ( ;; )
+    {
+        pid_t done = wait4( pid, &status, WNOHANG, &usage );
+        if ( done == pid )
+            break;
+        std::chrono::duration< double > wall = std::chrono::steady_clock::now() - start;
+        if ( ! timed_out && wall.count() > opts.time_cap )
+        {
+            kill( pid, SIGKILL );
+            timed_out = true;
+        }
+        std::this_thread::sleep_for( std::chrono::milliseconds( 20 ) );
+    }
+
+    std::chrono::duration< double > wall = std::chrono::steady_clock::now() - start;
+    m.wall = wall.count();
+    m.cpu = usage.ru_utime.tv_sec + usage.ru_utime.tv_usec * 1e-6
+          + usage.ru_stime.tv_sec + usage.ru_stime.tv_usec * 1e-6;
+    m.peak_rss_kb = usage.ru_maxrss;
+
+    bool exited = WIFEXITED( status ) && WEXITSTATUS( status ) == 0;
+    if ( timed_out )
+        m.status = "timeout";
+    else if ( ! exited && m.peak_rss_kb * 10 >= opts.memory_mb * 1024 * 9 )
+        m.status = "memout";
+    else if ( exited )
+        m.status = "ok";
+
+    std::ifstream in( report );
+    std::stringstream json;
+    json << in.rdbuf();
+    m.result = report_value( json.str(), "result" );
+    std::string clauses = report_value( json.str(), "clauses" );
+    std::string variables = report_value( json.str(), "variables" );
+    if ( ! clauses.empty() ) m.clauses = std::stod( clauses );
+    if ( ! variables.empty() ) m.variables = std::stod( variables );
+    std::remove( report.c_str() );
+
+    return m;
+}
+
+//// Growth ///////////////////////////////////////////////////////////////////
+
+// Fits log y = a + b n by least squares and returns e^b, the factor by
+// which y grows when n grows by one. Zero if there are too few points.
+double growth_rate( const std::vector< std::pair< int, double > > &points )
+{
+    double sn = 0, sy = 0, snn = 0, sny = 0;
+    int k = 0;
+    for ( auto [ n, y ] : points )
+    {
+        if ( y <= 0 )
+            continue;
+        double ly = std::log( y );
+        sn += n; sy += ly; snn += double( n ) * n; sny += n * ly;
+        k++;
+    }
+    if ( k < 2 || k * snn == sn * sn )
+        return 0;
+    return std::exp( ( k * sny - sn * sy ) / ( k * snn - sn * sn ) );
+}
+
+//// Main /////////////////////////////////////////////////////////////////////
+
+int main( int arc, char** argv )
+{
+    sweep_options_t opts;
+
+    std::string self = argv[ 0 ];
+    opts.bin = self.find( '/' ) == std::string::npos ? "." : self.substr( 0, self.rfind( '/' ) );
+
+    for ( int i = 1; i < arc; i++ )
+    {
+        std::string arg = argv[ i ];
+        auto value = [ & ]() { return arg.substr( arg.find( '=' ) + 1 ); };
+        if ( arg.rfind( "--from=", 0 ) == 0 ) opts.from = std::stoi( value() );
+        else if ( arg.rfind( "--to=", 0 ) == 0 ) opts.to = std::stoi( value() );
+        else if ( arg.rfind( "--run=", 0 ) == 0 ) opts.runs.push_back( value() );
+        else if ( arg.rfind( "--time=", 0 ) == 0 ) opts.time_cap = std::stod( value() );
+        else if ( arg.rfind( "--memory=", 0 ) == 0 ) opts.memory_mb = std::stol( value() );
+        else if ( arg.rfind( "--out=", 0 ) == 0 ) opts.out = value();
+        else if ( arg.rfind( "--bin=", 0 ) == 0 ) opts.bin = value();
+        else
+        {
+            std::cerr << "usage: sweep_combox [--from=n] [--to=n] [--run=\"engine flags\"]..."
+                         " [--time=s] [--memory=mb] [--out=path] [--bin=dir]\n";
+            return 1;
+        }
+    }
+    if ( opts.runs.empty() )
+        opts.runs = { "sat", "lattice", "z3" };
+
+    std::ofstream csv( opts.out );
+    csv << "config,n,status,result,wall_s,cpu_s,peak_rss_kb,clauses,variables\n";
+
+    std::map< std::string, std::vector< measurement_t > > by_config;
+    for ( auto &config : opts.runs )
+    {
+        for ( int n = opts.from; n <= opts.to; n++ )
+        {
+            auto m = run_once( opts, config, n );
+            csv << "\"" << m.config << "\"," << m.n << "," << m.status << "," << m.result
+                << "," << m.wall << "," << m.cpu << "," << m.peak_rss_kb
+                << "," << m.clauses << "," << m.variables << "\n";
+            csv.flush();
+            std::cout << config << " n=" << n << " " << m.status << " " << m.result
+                      << " " << m.wall << "s " << m.peak_rss_kb << "kB" << std::endl;
+            by_config[ config ].push_back( m );
+
+            // Larger n will only be worse.
+            if ( m.status != "ok" )
+                break;
+        }
+    }
+
+    for ( auto &[ config, ms ] : by_config )
+    {
+        std::vector< std::pair< int, double > > times, memory;
+        for ( auto &m : ms )
+            if ( m.status == "ok" )
+            {
+                times.push_back( { m.n, m.wall } );
+                memory.push_back( { m.n, double( m.peak_rss_kb ) } );
+            }
+        std::cout << config << ": time x" << growth_rate( times )
+                  << " per n, memory x" << growth_rate( memory ) << " per n" << std::endl;
+    }
+}
@@ -0,0 +1,134 @@
+#include <algorithm>
+#include <cassert>
+#include <numeric>
+#include <random>
+
+#include "cbx_canon.hpp"
+
+cbx::hypergraph_t random_hypergraph( std::mt19937 &rng, int n, double density )
+{
+    std::bernoulli_distribution coin( density );
+    cbx::hypergraph_t h( n );
+    for ( int i = 0; i < n; i++ )
+        for ( int j = i + 1; j < n; j++ )
+            for ( int k = j + 1; k < n; k++ )
+                if ( coin( rng ) )
+                    h.add_edge( i, j, k );
+    return h;
+}
+
+void test_isomorphic( std::mt19937 &rng, int n, double density )
+{
+    auto h = random_hypergraph( rng, n, density );
+
+    std::vector< int > perm( n );
+    std::iota( perm.begin(), perm.end(), 0 );
+    std::shuffle( perm.begin(), perm.end(), rng );
+
+    auto a = cbx::canonical_form( h );
+    auto b = cbx::canonical_form( cbx::permuted( h, perm ) );
+
+    assert( a == b );
+    assert( int( a.edges.count() ) == h.edge_count() );
+    // The labelling really maps h onto its canonical form.
+    assert( cbx::edge_bitset( cbx::permuted( h, a.labelling ) ) == a.edges );
+}
+
+// The group order matches a count of the permutations fixing h.
+void test_group_order( std::mt19937 &rng, int n, double density )
+{
+    auto h = random_hypergraph( rng, n, density );
+
+    std::uint64_t fixing = 0;
+    std::vector< int > perm( n );
+    std::iota( perm.begin(), perm.end(), 0 );
+    do
+        fixing += cbx::permuted( h, perm ) == h;
+    while ( std::next_permutation( perm.begin(), perm.end() ) );
+
+    assert( cbx::canonical_form( h ).group_order == fixing );
+}
+
+void test_distinct()
+{
+    // Two edges sharing one vertex, two vertices, or none.
+    cbx::hypergraph_t path( 6, { { 0, 1, 2 }, { 2, 3, 4 } } );
+    cbx::hypergraph_t twin( 6, { { 0, 1, 2 }, { 0, 1, 3 } } );
+    cbx::hypergraph_t apart( 6, { { 0, 1, 2 }, { 3, 4, 5 } } );
+
+    assert( cbx::canonical_form( path ) != cbx::canonical_form( twin ) );
+    assert( cbx::canonical_form( path ) != cbx::canonical_form( apart ) );
+    assert( cbx::canonical_form( twin ) != cbx::canonical_form( apart ) );
+    assert( cbx::canonical_form( path ) == cbx::canonical_form(
+                cbx::hypergraph_t( 6, { { 1, 3, 5 }, { 0, 2, 5 } } ) ) );
+}
+
+void test_symmetric()
+{
+    // Highly symmetric graphs are where automorphism pruning matters.
+    for ( int n = 3; n <= 10; n++ )
+    {
+        cbx::hypergraph_t empty( n );
+        cbx::hypergraph_t complete( n );
+        for ( int i = 0; i < n; i++ )
+            for ( int j = i + 1; j < n; j++ )
+                for ( int k = j + 1; k < n; k++ )
+                    complete.add_edge( i, j, k );
+
+        assert( cbx::canonical_form( empty ).edges.none() );
+        assert( cbx::canonical_form( complete ).edges.all() );
+    }
+}
+
+void test_orbit()
+{
+    assert( cbx::orbit( cbx::hypergraph_t( 5 ), 1000 ).size() == 1 );
+
+    // One edge can go to any of the C( 5, 3 ) triples.
+    cbx::hypergraph_t single( 5, { { 0, 1, 2 } } );
+    auto images = cbx::orbit( single, 1000 );
+    assert( images.size() == 10 );
+    assert( images[ 0 ] == single );
+    for ( [[maybe_unused]] auto &image : images )
+        assert( cbx::canonical_form( image ) == cbx::canonical_form( single ) );
+
+    assert( cbx::orbit( single, 4 ).size() == 4 );
+
+    // Two disjoint edges, 6! / ( 2 * 3! * 3! ) images.
+    cbx::hypergraph_t apart( 6, { { 0, 1, 2 }, { 3, 4, 5 } } );
+    assert( cbx::canonical_form( apart ).group_order == 72 );
+    assert( cbx::orbit( apart, 1000 ).size() == 10 );
+}
+
+void test_degrees()
+{
+    cbx::hypergraph_t h( 6, { { 0, 1, 2 }, { 2, 1, 3 }, { 5, 4, 2 } } );
+    assert( h.has_edge( 1, 2, 3 ) && h.has_edge( 2, 4, 5 ) && ! h.has_edge( 0, 1, 3 ) );
+    assert( h.degree( 2 ) == 3 && h.degree( 1 ) == 2 && h.degree( 0 ) == 1 );
+    assert( h.codegree( 1, 2 ) == 2 && h.codegree( 2, 1 ) == 2 && h.codegree( 0, 5 ) == 0 );
+
+    for ( int e = 0; e < cbx::max_edges; e++ )
+    {
+        [[maybe_unused]] auto [ i, j, k ] = cbx::triple_of[ e ];
+        assert( i < j && j < k && k < cbx::max_vertices );
+        assert( cbx::rank_3( i, j, k ) == e );
+    }
+}
+
+int main()
+{
+    std::mt19937 rng( 26 );
+    for ( int n = 3; n <= 10; n++ )
+        for ( double density : { 0.1, 0.3, 0.5, 0.8 } )
+            for ( int round = 0; round < 5; round++ )
+                test_isomorphic( rng, n, density );
+    for ( int n = 3; n <= 7; n++ )
+        for ( double density : { 0.1, 0.3, 0.5, 0.8 } )
+            for ( int round = 0; round < 10; round++ )
+                test_group_order( rng, n, density );
+
+    test_distinct();
+    test_symmetric();
+    test_orbit();
+    test_degrees();
+}
@@ -0,0 +1,125 @@
+#include <cassert>
+#include <cstdio>
+#include <random>
+#include <sstream>
+
+#include "cbx_hgio.hpp"
+
+cbx::hypergraph_t random_hypergraph( std::mt19937 &rng, int n, double density )
+{
+    std::bernoulli_distribution coin( density );
+    cbx::hypergraph_t h( n );
+    for ( int i = 0; i < n; i++ )
+        for ( int j = i + 1; j < n; j++ )
+            for ( int k = j + 1; k < n; k++ )
+                if ( coin( rng ) )
+                    h.add_edge( i, j, k );
+    return h;
+}
+
+void test_roundtrip( std::mt19937 &rng, int n )
+{
+    const char *path = "tst_cbx_hgio.hg";
+    std::vector< cbx::hypergraph_t > graphs;
+    for ( int i = 0; i < 100; i++ )
+        graphs.push_back( random_hypergraph( rng, n, i / 100.0 ) );
+
+    {
+        // A small buffer, so the writer flushes on the way.
+        cbx::hg_writer_t writer( path, n, 64 );
+        for ( auto &h : graphs )
+            writer.write( h );
+    }
+
+    cbx::hg_reader_t reader( path );
+    assert( reader.n == n );
+    assert( reader.size() == graphs.size() );
+    // Random access, back to front.
+    for ( std::size_t i = graphs.size(); i-- > 0; )
+        assert( reader.graph( i ) == graphs[ i ] );
+    std::remove( path );
+}
+
+void test_unfinished()
+{
+    const char *path = "tst_cbx_hgio.hg";
+    cbx::hypergraph_t h( 7, { { 0, 1, 2 }, { 4, 5, 6 } } );
+
+    // The count in the header is only written by close.
+    cbx::hg_writer_t writer( path, 7 );
+    writer.write( h );
+    writer.write( h );
+    writer.flush();
+
+    cbx::hg_reader_t reader( path );
+    assert( reader.size() == 2 );
+    assert( reader.graph( 1 ) == h );
+
+    writer.close();
+    std::remove( path );
+}
+
+// Records on fewer than three vertices would be empty.
+void test_small_n()
+{
+    const char *path = "tst_cbx_hgio.hg";
+
+    [[maybe_unused]] bool thrown = false;
+    try { cbx::hg_writer_t writer( path, 2 ); } catch ( const std::invalid_argument& ) { thrown = true; }
+    assert( thrown );
+
+    unsigned char header[ cbx::hg_header_bytes ] = { 'C', 'B', 'X', 'H', 1, 2 };
+    std::FILE *file = std::fopen( path, "wb" );
+    std::fwrite( header, 1, sizeof header, file );
+    std::fclose( file );
+
+    thrown = false;
+    try { cbx::hg_reader_t reader( path ); } catch ( const std::runtime_error& ) { thrown = true; }
+    assert( thrown );
+    std::remove( path );
+}
+
+void test_text( std::mt19937 &rng )
+{
+    std::stringstream text;
+    std::vector< cbx::hypergraph_t > graphs;
+    for ( int n = 3; n <= 9; n++ )
+    {
+        graphs.push_back( random_hypergraph( rng, n, 0.4 ) );
+        text << graphs.back() << "\n";
+    }
+    text << cbx::hypergraph_t( 5 ) << "\n";
+    graphs.push_back( cbx::hypergraph_t( 5 ) );
+
+    cbx::hypergraph_t h( 0 );
+    // read_text is called outside assert, which NDEBUG compiles out.
+    for ( [[maybe_unused]] auto &g : graphs )
+    {
+        [[maybe_unused]] bool read = cbx::read_text( text, h );
+        assert( read );
+        assert( h == g );
+    }
+    [[maybe_unused]] bool more = cbx::read_text( text, h );
+    assert( ! more );
+
+    // Vertices out of range or repeated, and too many vertices.
+    for ( const char *bad : { "Hypergraph[4]{{0,1,4}}", "Hypergraph[4]{{-1,1,2}}"
+                            , "Hypergraph[4]{{0,2,2}}", "Hypergraph[17]{}"
+                            , "Hypergraph[x]{}" } )
+    {
+        std::stringstream in( bad );
+        [[maybe_unused]] bool thrown = false;
+        try { cbx::read_text( in, h ); } catch ( const std::runtime_error& ) { thrown = true; }
+        assert( thrown );
+    }
+}
+
+int main()
+{
+    std::mt19937 rng( 46 );
+    for ( int n = 3; n <= 12; n++ )
+        test_roundtrip( rng, n );
+    test_unfinished();
+    test_small_n();
+    test_text( rng );
+}
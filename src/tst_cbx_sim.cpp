@@ -0,0 +1,65 @@
+#include <algorithm>
+#include <cassert>
+#include <numeric>
+
+#include "cbx_sim.hpp"
+
+void test_binomial()
+{
+    for ( int n = 0; n <= cbx::max_wide_n; n++ )
+    {
+        cbx::uint128_t sum = 0;
+        for ( int k = 0; k <= n; k++ )
+        {
+            cbx::uint128_t c = cbx::binomial_wide( n, k );
+            assert( c == cbx::binomial_wide( n, n - k ) );
+            if ( n > 0 && k > 0 && k < n )
+                assert( c == cbx::binomial_wide( n - 1, k - 1 ) + cbx::binomial_wide( n - 1, k ) );
+            if ( n <= cbx::max_pascal_n )
+                assert( c == cbx::binomial( n, k ) );
+            sum += c;
+        }
+        // The row sums to 2^n.
+        if ( n < 128 )
+            assert( sum == cbx::uint128_t( 1 ) << n );
+    }
+
+    assert( cbx::binomial( 100, 3 ) == 161700 );
+    assert( cbx::binomial( 5, -1 ) == 0 && cbx::binomial( 5, 6 ) == 0 );
+
+    [[maybe_unused]] bool thrown = false;
+    try { cbx::binomial( 100, 50 ); } catch ( std::overflow_error& ) { thrown = true; }
+    assert( thrown );
+
+    thrown = false;
+    try { cbx::choose( 40, 20 ); } catch ( std::overflow_error& ) { thrown = true; }
+    assert( thrown );
+}
+
+void test_perm_rank()
+{
+    for ( int n = 0; n <= 6; n++ )
+    {
+        std::vector< int > perm( n );
+        std::iota( perm.begin(), perm.end(), 0 );
+        std::uint64_t rank = 0;
+        do
+        {
+            assert( cbx::perm_rank( perm ) == rank );
+            assert( cbx::perm_unrank( n, rank ) == perm );
+            rank++;
+        } while ( std::next_permutation( perm.begin(), perm.end() ) );
+        assert( rank == cbx::factorial( n ) );
+    }
+
+    std::uint64_t last = cbx::factorial( cbx::max_factorial_n ) - 1;
+    auto reversed = cbx::perm_unrank( cbx::max_factorial_n, last );
+    assert( std::is_sorted( reversed.rbegin(), reversed.rend() ) );
+    assert( cbx::perm_rank( reversed ) == last );
+}
+
+int main()
+{
+    test_binomial();
+    test_perm_rank();
+}
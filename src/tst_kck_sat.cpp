@@ -1,6 +1,8 @@
 #include "kck_sat.hpp"
 #include "kck_form.hpp"
 #include "kck_cnf.hpp" 
+#include "kck_qbf.hpp"
+#include "kck_z3.hpp"
 
 using var_t = std::string;
 using lit_t = kck::literal< var_t >;
@@ -20,10 +22,66 @@ void test_case( forms::form_p form, bool t )
 
     assert( res != SAT_U );
     assert( ( res == SAT_Y ) == t );
+
+    // The z3 backend agrees, on the formula and on its CNF.
+    z3::context ctx;
+    kck::z3_lowering_t< lit_t > lowering( ctx );
+    z3::solver direct( ctx ), clausal( ctx );
+    direct.add( lowering.lower( form ) );
+    clausal.add( lowering.lower( form->to_cnf( labeler ) ) );
+    assert( ( direct.check() == z3::sat ) == t );
+    assert( ( clausal.check() == z3::sat ) == t );
+}
+
+void test_qbf2( std::vector< var_t > exists
+              , std::vector< var_t > forall
+              , forms::form_p matrix
+              , int expected
+              , std::map< var_t, bool > model = {} )
+{
+    kck::cnf_builder< lit_t > builder( labeler );
+    kck::qbf2_t< lit_t > problem{ exists, forall, nullptr, matrix };
+    auto res = kck::solve_qbf2( problem, builder );
+
+    assert( res.res == expected );
+    for ( auto &[ var, value ] : model )
+        assert( res.model.at( var ) == value );
+}
+
+// Units on variables which are not frozen survive copy_configured.
+void test_copy_configured()
+{
+    kck::sat_solver_t base;
+    kck::add_cnf( base, kck::cnf_t< int >{ { 1 }, { -2 }, { 2, 3 } } );
+
+    kck::sat_solver_t copy;
+    kck::copy_configured( base, copy, { "unsat", "unsat", {} } );
+    assert( copy.solve() == SAT_Y );
+    assert( copy.val( 1 ) > 0 && copy.val( 2 ) < 0 && copy.val( 3 ) > 0 );
+}
+
+// A proof which cannot reach the disk makes close throw.
+void test_proof_sink_failure()
+{
+    kck::sat_solver_t solver;
+    kck::proof_sink proof( solver, "/nonexistent/proof.drat", false );
+    kck::add_cnf( solver, kck::cnf_t< int >{ { 1 }, { -1 } } );
+    solver.solve();
+
+    [[maybe_unused]] bool thrown = false;
+    try { proof.close(); } catch ( const std::runtime_error& ) { thrown = true; }
+    assert( thrown );
+}
+
+forms::form_p lit( const var_t &v, bool pos = true )
+{
+    return forms::f_lit( { v, pos } );
 }
 
 int main()
 {
+    test_copy_configured();
+    test_proof_sink_failure();
     test_case( forms::f_and( { forms::f_lit( { "A", true } )
                              , forms::f_lit( { "B", true } ) } )
              , true );
@@ -42,4 +100,25 @@ int main()
                              , forms::f_or( { forms::f_lit( { "A", false } )
                                             , forms::f_lit( { "B", false } ) } ) } )
              , false );
+
+    // exists a forall b . ( a or b ) and ( a or not b )
+    test_qbf2( { "a" }, { "b" }
+             , forms::f_and( { forms::f_or( { lit( "a" ), lit( "b" ) } )
+                             , forms::f_or( { lit( "a" ), lit( "b", false ) } ) } )
+             , SAT_Y, { { "a", true } } );
+    // exists a forall b . a <-> b
+    test_qbf2( { "a" }, { "b" }
+             , forms::f_and( { forms::f_or( { lit( "a", false ), lit( "b" ) } )
+                             , forms::f_or( { lit( "a" ), lit( "b", false ) } ) } )
+             , SAT_N );
+    // exists a c forall b . ( a or b ) and ( c or not b ) and not ( a and c and b )
+    test_qbf2( { "a", "c" }, { "b" }
+             , forms::f_and( { forms::f_or( { lit( "a" ), lit( "b" ) } )
+                             , forms::f_or( { lit( "c" ), lit( "b", false ) } )
+                             , forms::f_not( forms::f_and( { lit( "a" ), lit( "c" ), lit( "b" ) } ) ) } )
+             , SAT_N );
+    test_qbf2( { "a", "c" }, { "b" }
+             , forms::f_and( { forms::f_or( { lit( "a" ), lit( "b" ) } )
+                             , forms::f_or( { lit( "c" ), lit( "b", false ) } ) } )
+             , SAT_Y, { { "a", true }, { "c", true } } );
 }